@@ -7,6 +7,11 @@ from sklearn.model_selection import train_test_split
 from sklearn.metrics import mean_squared_error
 from sklearn.impute import SimpleImputer
 import joblib
+import os
+import sys
+
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+from export_model import export_model
 
 
 def load_and_clean(filepath, columns):
@@ -292,6 +297,8 @@ if __name__ == "__main__":
     joblib.dump(imputer, "ao_imputer2.pkl")
     # Save scaler
     joblib.dump(scaler, "ao_scaler2.pkl")
+    # Same model for the native inference in the C++ service (--model)
+    export_model(model, scaler, imputer, "ao_model2.bin")
 
     # use the model to predict the steering angle using some arbitrary data, one
     PredictionData = preprocess_prediction_data(
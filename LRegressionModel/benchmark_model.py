@@ -0,0 +1,89 @@
+"""Time the joblib steering model on the recorded sensor data, and write the same feature rows
+for the native benchmark of the C++ service.
+
+Every AngularVelocityReading of the recordings becomes one feature row, with the latest IR
+voltages (sender stamps 1 and 3) received before it, as the service sees them. The rows and the
+sklearn predictions are written to the output CSV, which `main --model-benchmark=<csv>
+--model=<exported model>` reads to check its predictions and time the native evaluation.
+
+    python3 benchmark_model.py Models/RFT_GRIDSEARCH/ao_model.pkl Models/RFT_GRIDSEARCH/ao_scaler.pkl \
+        Models/RFT_GRIDSEARCH/ao_imputer.pkl model_benchmark.csv CSV-Files/*.rec.csv
+"""
+
+import glob
+import os
+import sys
+import time
+
+import joblib
+import numpy as np
+import pandas as pd
+
+from export_model import FEATURES
+
+
+def load_sensor(path, columns):
+    df = pd.read_csv(path, delimiter=";", usecols=["sampleTimeStamp.seconds", "sampleTimeStamp.microseconds"] + columns)
+    df["time"] = df["sampleTimeStamp.seconds"] * 1000000 + df["sampleTimeStamp.microseconds"]
+    return df[["time"] + columns].sort_values("time")
+
+
+def recording_features(directory):
+    """Feature rows of one recording, in the order of FEATURES."""
+    rows = load_sensor(os.path.join(directory, "opendlv.proxy.AngularVelocityReading-0.csv"), FEATURES[:3])
+    for stamp, name in ((1, "voltage_x"), (3, "voltage_y")):
+        path = os.path.join(directory, f"opendlv.proxy.VoltageReading-{stamp}.csv")
+        ir = load_sensor(path, ["voltage"]).rename(columns={"voltage": name})
+        rows = pd.merge_asof(rows, ir, on="time", direction="backward")
+    return rows[FEATURES]
+
+
+def call_latencies(function, calls):
+    """Seconds per call, one entry per call."""
+    latencies = np.empty(calls)
+    for i in range(calls):
+        start = time.perf_counter()
+        function(i)
+        latencies[i] = time.perf_counter() - start
+    return latencies
+
+
+def main(model_path, scaler_path, imputer_path, output, recordings):
+    model = joblib.load(model_path)
+    scaler = joblib.load(scaler_path)
+    imputer = joblib.load(imputer_path)
+    columns = FEATURES[: len(scaler.mean_)]
+    # The scaler was fitted on the training column names, the voltages as voltage_x / voltage_y.
+    data = pd.concat([recording_features(directory) for directory in recordings], ignore_index=True)
+    frame = data[columns]
+
+    predictions = model.predict(imputer.transform(scaler.transform(frame)))
+    out = data.copy()
+    out["expected"] = predictions
+    out.to_csv(output, index=False, float_format="%.17g", na_rep="nan")
+    print(f"{len(data)} feature rows from {len(recordings)} recordings written to {output}")
+
+    # One prediction per call as in service.py: a DataFrame per sample. Same percentiles as the
+    # native benchmark, so the two can be put side by side.
+    calls = min(len(data), 1000)
+    samples = frame.to_dict("records")
+    single_df = call_latencies(
+        lambda i: model.predict(imputer.transform(scaler.transform(pd.DataFrame([samples[i]])))), calls
+    )
+    start = time.perf_counter()
+    model.predict(imputer.transform(scaler.transform(frame)))
+    batch = time.perf_counter() - start
+    p50, p99 = np.percentile(single_df, [50, 99]) * 1e6
+    print(
+        f"joblib model, one DataFrame per prediction (service.py), {calls} calls: "
+        f"p50 {p50:.1f} us, p99 {p99:.1f} us, max {single_df.max() * 1e6:.1f} us"
+    )
+    print(f"joblib model, batch of {len(data)}: {len(data) / batch:.0f} predictions/s")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 6:
+        print(__doc__)
+        sys.exit(1)
+    directories = [path for pattern in sys.argv[5:] for path in glob.glob(pattern)]
+    main(sys.argv[1], sys.argv[2], sys.argv[3], sys.argv[4], directories)
@@ -0,0 +1,98 @@
+"""Export a trained steering model for the native inference in the C++ service.
+
+Writes the scaler, the imputer and the trees of a RandomForestRegressor or a
+GradientBoostingRegressor into the flat binary format read by src/SteeringModel.cpp, so the
+model can run inside the control loop instead of in service.py.
+
+    python3 export_model.py Models/RFT_ANGULAR/ao_model.pkl Models/RFT_ANGULAR/ao_scaler.pkl \
+        Models/RFT_ANGULAR/ao_imputer.pkl steering_model.bin
+    python3 export_model.py Models/GradientBoosting/ao_model.pkl Models/GradientBoosting/ao_scaler.pkl \
+        Models/GradientBoosting/ao_imputer.pkl Models/GradientBoosting/boosting_model.bin
+"""
+
+import struct
+import sys
+
+import joblib
+import numpy as np
+
+MAGIC = b"D639TREE"
+FORMAT_VERSION = 1
+
+# Order of the features in the C++ SteeringModel::Feature enum and in train.py.
+FEATURES = [
+    "angularVelocityX",
+    "angularVelocityY",
+    "angularVelocityZ",
+    "voltage_x",
+    "voltage_y",
+]
+
+
+def tree_nodes(tree):
+    """Nodes of a fitted sklearn tree as (feature, threshold, left, right, value) tuples."""
+    nodes = []
+    for i in range(tree.node_count):
+        left = int(tree.children_left[i])
+        right = int(tree.children_right[i])
+        value = float(tree.value[i].ravel()[0])
+        if left == -1:
+            nodes.append((-1, 0.0, -1, -1, value))
+        else:
+            nodes.append((int(tree.feature[i]), float(tree.threshold[i]), left, right, value))
+    return nodes
+
+
+def model_trees(model):
+    """Trees, bias and tree scale of a supported model: prediction = bias + scale * sum(trees)."""
+    estimators = getattr(model, "estimators_", None)
+    if estimators is None:
+        raise ValueError(f"{type(model).__name__} is not a supported tree ensemble")
+    trees = [estimator.tree_ for estimator in np.ravel(estimators)]
+    if not hasattr(model, "learning_rate"):
+        return trees, 0.0, 1.0 / len(trees)
+
+    # Gradient boosting: the initial estimator's prediction plus learning_rate times every tree.
+    if np.shape(estimators)[1] != 1:
+        raise ValueError("only single-output gradient boosting regression is supported")
+    if isinstance(model.init_, str) and model.init_ == "zero":
+        bias = 0.0
+    elif hasattr(model.init_, "constant_"):
+        bias = float(np.ravel(model.init_.constant_)[0])
+    else:
+        raise ValueError(f"the initial estimator {type(model.init_).__name__} is not a constant")
+    return trees, bias, float(model.learning_rate)
+
+
+def export_model(model, scaler, imputer, path):
+    trees, bias, tree_scale = model_trees(model)
+    feature_count = len(scaler.mean_)
+    if feature_count > len(FEATURES):
+        raise ValueError(f"{feature_count} features, the native model supports {len(FEATURES)}")
+    if np.isnan(imputer.statistics_).any() or len(imputer.statistics_) != feature_count:
+        raise ValueError("the imputer must have one statistic per feature")
+    scale = scaler.scale_ if scaler.scale_ is not None else np.ones(feature_count)
+
+    with open(path, "wb") as out:
+        out.write(MAGIC)
+        out.write(struct.pack("<III", FORMAT_VERSION, feature_count, len(trees)))
+        out.write(struct.pack("<dd", bias, tree_scale))
+        for values in (scaler.mean_, scale, imputer.statistics_):
+            out.write(struct.pack(f"<{feature_count}d", *values))
+        for tree in trees:
+            nodes = tree_nodes(tree)
+            out.write(struct.pack("<I", len(nodes)))
+            for feature, threshold, left, right, value in nodes:
+                out.write(struct.pack("<idiid", feature, threshold, left, right, value))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 5:
+        print(__doc__)
+        sys.exit(1)
+    export_model(
+        joblib.load(sys.argv[1]),
+        joblib.load(sys.argv[2]),
+        joblib.load(sys.argv[3]),
+        sys.argv[4],
+    )
@@ -6,6 +6,7 @@ from sklearn.model_selection import train_test_split
 from sklearn.metrics import mean_squared_error
 from sklearn.impute import SimpleImputer
 import joblib
+from export_model import export_model
 
 
 def load_and_clean(filepath, columns):
@@ -268,6 +269,8 @@ if __name__ == "__main__":
     joblib.dump(imputer, "ao_imputer.pkl")
     # Save scaler
     joblib.dump(scaler, "ao_scaler.pkl")
+    # Same model for the native inference in the C++ service (--model)
+    export_model(model, scaler, imputer, "ao_model.bin")
 
     # load the trained model
     model = joblib.load("modelmultiple.pkl")
@@ -2,116 +2,132 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include "CommonDefs.hpp"
 #include "AngleCalculator.hpp"
+#include "SteeringPolicy.hpp"
+#include <chrono>
 #include <iostream>
 
-AngleCalculator::AngleCalculator() {}
+AngleCalculator::AngleCalculator()
+    : blueBlobs(),
+      yellowBlobs(),
+      filteredBlueBlobs(),
+      filteredYellowBlobs(),
+      detectionRecord()
+{
+}
 
 float AngleCalculator::CalculateSteeringAngle(cv::Mat &yellowInputImage, cv::Mat &blueInputImage, float &steeringWheelAngle, bool isClockwise, float maxSteering, float minSteering, bool VERBOSE)
 {
-    std::vector<std::vector<cv::Point>> blueContours;
-    std::vector<std::vector<cv::Point>> yellowContours;
+    ExtractBlobs(yellowInputImage, blueInputImage);
+    return steerFromBlobs(yellowBlobs.blobs(), blueBlobs.blobs(), blueInputImage.size(), steeringWheelAngle, isClockwise, maxSteering, minSteering, VERBOSE);
+}
 
+void AngleCalculator::ExtractBlobs(const cv::Mat &yellowInputImage, const cv::Mat &blueInputImage)
+{
     // Assuming you know the dimensions of the image and the distracting area
-    int cropHeight = 100; // Height in pixels to crop from the bottom
-    cv::Rect roi(0, 0, yellowInputImage.cols, yellowInputImage.rows - cropHeight);
+    cv::Rect roi(0, 0, yellowInputImage.cols, yellowInputImage.rows - CROP_HEIGHT);
     cv::Mat croppedBlueImage = blueInputImage(roi);
     cv::Mat croppedYellowImage = yellowInputImage(roi);
 
-    cv::findContours(croppedBlueImage, blueContours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
-    cv::findContours(croppedYellowImage, yellowContours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+    // One raster scan per mask gives area, bounding box and moments of every blob.
+    blueBlobs.Extract(croppedBlueImage);
+    yellowBlobs.Extract(croppedYellowImage);
+}
+
+float AngleCalculator::CalculateSteeringAngle(const std::vector<Blob> &yellow, const std::vector<Blob> &blue, const cv::Size &imageSize, float &steeringWheelAngle, bool isClockwise, float maxSteering, float minSteering, bool VERBOSE)
+{
+    return steerFromBlobs(yellow, blue, imageSize, steeringWheelAngle, isClockwise, maxSteering, minSteering, VERBOSE);
+}
 
+float AngleCalculator::steerFromBlobs(const std::vector<Blob> &yellow, const std::vector<Blob> &blue, const cv::Size &imageSize, float steeringWheelAngle, bool isClockwise, float maxSteering, float minSteering, bool VERBOSE)
+{
     // Define minimum and maximum contour areas
-    double minArea = 130.0;  // Minimum area to consider a contour
-    double maxArea = 1000.0; // Maximum area to avoid abnormally large contours
+    double minArea = MIN_CONE_AREA; // Minimum area to consider a contour
+    double maxArea = MAX_CONE_AREA; // Maximum area to avoid abnormally large contours
 
     // Define aspect ratio thresholds (specific to the expected shape of the cones)
     float minAspectRatio = 0.5; // Minimum aspect ratio
     float maxAspectRatio = 2.0; // Maximum aspect ratio
 
-    std::vector<std::vector<cv::Point>> filteredYellowContours;
-    for (const auto &contour : yellowContours)
+    filteredYellowBlobs.clear();
+    for (size_t i = 0; i < yellow.size(); i++)
     {
-        double area = cv::contourArea(contour);
+        // Same area as cv::contourArea of the blob's contour
+        double area = yellow[i].contourArea;
 
-        // Calculate bounding rectangle to get aspect ratio
-        cv::Rect boundingBox = cv::boundingRect(contour);
+        // Use the bounding rectangle to get aspect ratio
+        const cv::Rect &boundingBox = yellow[i].boundingBox;
         float aspectRatio = static_cast<float>(boundingBox.width) / boundingBox.height;
 
-        // Check if contour matches area and aspect ratio criteria
+        // Check if blob matches area and aspect ratio criteria
         if (area >= minArea && area <= maxArea && aspectRatio >= minAspectRatio && aspectRatio <= maxAspectRatio)
         {
-            filteredYellowContours.push_back(contour);
+            filteredYellowBlobs.push_back(i);
         }
     }
 
-    // Filter blue contours based on area
-    std::vector<std::vector<cv::Point>> filteredBlueContours;
-    for (const auto &contour : blueContours)
+    // Filter blue blobs based on area
+    filteredBlueBlobs.clear();
+    for (size_t i = 0; i < blue.size(); i++)
     {
-        double area = cv::contourArea(contour);
+        double area = blue[i].contourArea;
         if (area >= minArea && area <= maxArea)
         {
-            filteredBlueContours.push_back(contour);
+            filteredBlueBlobs.push_back(i);
         }
     }
 
     // Calculate points that divide the screen into three equal vertical sections
-    cv::Point imageCenter(blueInputImage.cols / 2, blueInputImage.rows / 2);
-    cv::Point imageLeftThird(blueInputImage.cols / 3, blueInputImage.rows / 2);      // One third from the left
-    cv::Point imageRightThird(blueInputImage.cols * 2 / 3, blueInputImage.rows / 2); // Two thirds from the left
-
-    cv::Point blueCentroid = calculateCentroid(filteredBlueContours, imageCenter);
-    cv::Point yellowCentroid = calculateCentroid(filteredYellowContours, imageCenter);
-
-    // Create a visual output by combining the blue and yellow images
-    cv::Mat visualOutput;
-    cv::cvtColor(blueInputImage, visualOutput, cv::COLOR_GRAY2BGR); // Convert blue image to color for visualization
-    cv::Mat yellowBGR;
-    cv::cvtColor(yellowInputImage, yellowBGR, cv::COLOR_GRAY2BGR);         // Convert yellow image to color
-    cv::addWeighted(visualOutput, 0.5, yellowBGR, 0.5, 0.0, visualOutput); // Blend both images
-
-    // Draw image center
-    cv::circle(visualOutput, imageCenter, 5, cv::Scalar(0, 255, 0), -1); // Green color
+    cv::Point imageCenter(imageSize.width / 2, imageSize.height / 2);
+    cv::Point imageLeftThird(imageSize.width / 3, imageSize.height / 2);      // One third from the left
+    cv::Point imageRightThird(imageSize.width * 2 / 3, imageSize.height / 2); // Two thirds from the left
 
-    // Draw centroids
-    cv::circle(visualOutput, blueCentroid, 5, cv::Scalar(255, 0, 0), -1);     // Blue color for blue centroid
-    cv::circle(visualOutput, yellowCentroid, 5, cv::Scalar(0, 255, 255), -1); // Yellow color for yellow centroid
+    cv::Point blueCentroid = calculateCentroid(blue, filteredBlueBlobs, imageCenter);
+    cv::Point yellowCentroid = calculateCentroid(yellow, filteredYellowBlobs, imageCenter);
 
-    // Draw lines from image center to centroids
-    cv::line(visualOutput, imageCenter, blueCentroid, cv::Scalar(255, 0, 0), 2);     // Blue line to blue centroid
-    cv::line(visualOutput, imageCenter, yellowCentroid, cv::Scalar(0, 255, 255), 2); // Yellow line to yellow centroid
-
-    // Drawing the division lines on the image for visual verification
-    cv::line(visualOutput, cv::Point(imageLeftThird.x, 0), cv::Point(imageLeftThird.x, visualOutput.rows), cv::Scalar(0, 255, 0), 2);   // Green line for left third
-    cv::line(visualOutput, cv::Point(imageRightThird.x, 0), cv::Point(imageRightThird.x, visualOutput.rows), cv::Scalar(0, 255, 0), 2); // Green line for right third
+    float newSteering = steeringWheelAngle;
+    newSteering = adjustSteering(newSteering, blueCentroid, yellowCentroid, imageCenter, imageLeftThird, imageRightThird, isClockwise, VERBOSE);
 
-    // Display the visual output if VERBOSE is enabled
-    if (VERBOSE)
+    // Hand what was found to the debug view; it is drawn on the sink's thread.
+    const auto now = std::chrono::steady_clock::now();
+    if (visualizationSink != nullptr && visualizationSink->Due(now))
     {
-        cv::imshow("Visual Output", visualOutput);
+        detectionRecord.imageSize = imageSize;
+        detectionRecord.imageCenter = imageCenter;
+        detectionRecord.blueCentroid = blueCentroid;
+        detectionRecord.yellowCentroid = yellowCentroid;
+        detectionRecord.leftThirdX = imageLeftThird.x;
+        detectionRecord.rightThirdX = imageRightThird.x;
+        detectionRecord.blueBoxes.clear();
+        for (size_t index : filteredBlueBlobs)
+        {
+            detectionRecord.blueBoxes.push_back(blue[index].boundingBox);
+        }
+        detectionRecord.yellowBoxes.clear();
+        for (size_t index : filteredYellowBlobs)
+        {
+            detectionRecord.yellowBoxes.push_back(yellow[index].boundingBox);
+        }
+        detectionRecord.steering = newSteering;
+        visualizationSink->Submit(detectionRecord, now);
     }
 
-    float newSteering = steeringWheelAngle;
-    newSteering = adjustSteering(newSteering, blueCentroid, yellowCentroid, imageCenter, imageLeftThird, imageRightThird, isClockwise, VERBOSE);
-
     // Clamp the steering value to be within allowed limits
     // newSteering = std::max(minSteering, std::min(maxSteering, newSteering));
 
     return newSteering;
 }
 
-cv::Point AngleCalculator::calculateCentroid(const std::vector<std::vector<cv::Point>> &contours, const cv::Point &imageCenter)
+cv::Point AngleCalculator::calculateCentroid(const std::vector<Blob> &blobs, const std::vector<size_t> &selected, const cv::Point &imageCenter)
 {
-    cv::Moments m;
     int xSum = 0, ySum = 0, count = 0;
 
-    for (const auto &contour : contours)
+    for (size_t index : selected)
     {
-        m = cv::moments(contour);
-        if (m.m00 > std::numeric_limits<double>::epsilon())
-        { // Avoid division by zero by checking against epsilon
-            xSum += static_cast<int>(m.m10 / m.m00);
-            ySum += static_cast<int>(m.m01 / m.m00);
+        const Blob &blob = blobs[index];
+        if (blob.area > 0)
+        { // Avoid division by zero
+            xSum += static_cast<int>(blob.m10 / blob.area);
+            ySum += static_cast<int>(blob.m01 / blob.area);
             count++;
         }
     }
@@ -120,163 +136,21 @@ cv::Point AngleCalculator::calculateCentroid(const std::vector<std::vector<cv::P
 
 float AngleCalculator::adjustSteering(float &newSteering, cv::Point &blueCentroid, cv::Point yellowCentroid, const cv::Point &imageCenter, const cv::Point &imageLeftThird, const cv::Point &imageRightThird, bool isClockwise, bool VERBOSE)
 {
-    // Define how much to adjust steering when necessary
-    // float steeringAdjustmentAmount = 0.05f;  // This value might need tuning
-
-    // For clockwise direction: Blue cones on the left, Yellow cones on the right
-    if (isClockwise)
-    {
-
-        if (VERBOSE)
-        {
-            std::cout << "Clockwise Direction" << std::endl;
-        }
-        // Check if blue cones have crossed from the left third into the center
-        if (blueCentroid.x < imageLeftThird.x && yellowCentroid.x > imageRightThird.x)
-        {
+    // The decision tables live in SteeringPolicy.hpp; here the centroids are placed relative to
+    // the three vertical lines and the direction picks which table to read.
+    const SteeringRegion blueRegion = steeringRegion(blueCentroid.x, imageLeftThird.x, imageCenter.x, imageRightThird.x);
+    const SteeringRegion yellowRegion = steeringRegion(yellowCentroid.x, imageLeftThird.x, imageCenter.x, imageRightThird.x);
+    const SteeringZone &zone = isClockwise ? SteeringPolicy<TrackDirection::Clockwise>::Decide(blueRegion, yellowRegion)
+                                           : SteeringPolicy<TrackDirection::CounterClockwise>::Decide(blueRegion, yellowRegion);
 
-            if (VERBOSE)
-            {
-                std::cout << "Driving Straight" << std::endl;
-            }
-            newSteering = 0.0f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        if (blueCentroid.x > imageLeftThird.x && blueCentroid.x < imageRightThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right" << std::endl;
-            }
-            newSteering = -0.11f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        if (blueCentroid.x > imageCenter.x && blueCentroid.x < imageRightThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right Sharp" << std::endl;
-            }
-            newSteering = -0.17f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        if (blueCentroid.x > imageRightThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right Sharpest" << std::endl;
-            }
-            newSteering = -0.225f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-
-        // Check if yellow cones have crossed from the right third into the center
-        if (yellowCentroid.x < imageRightThird.x && yellowCentroid.x > imageCenter.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Left" << std::endl;
-            }
-            newSteering = 0.11f;
-            return newSteering; // Steer left to adjust for yellow cone moving towards center
-        }
-        if (yellowCentroid.x < imageCenter.x && yellowCentroid.x > imageLeftThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Left Sharp" << std::endl;
-            }
-            newSteering = 0.17f;
-            return newSteering; // Steer left to adjust for yellow cone moving towards center
-        }
-        if (yellowCentroid.x > imageLeftThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Left Sharpest" << std::endl;
-            }
-            newSteering = 0.225f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-    }
-    // For counter-clockwise direction: Blue cones on the right, Yellow cones on the left
-    else
+    if (VERBOSE)
     {
-        if (VERBOSE)
-        {
-            std::cout << "Counter-Clockwise Direction" << std::endl;
-        }
-        // Blue cones on the right
-        if (blueCentroid.x > imageRightThird.x && yellowCentroid.x < imageLeftThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Driving Straight" << std::endl;
-            }
-            newSteering = 0.0f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        if (blueCentroid.x < imageRightThird.x && blueCentroid.x > imageLeftThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right" << std::endl;
-            }
-            newSteering = 0.11f;
-            return newSteering;
-        }
-        if (blueCentroid.x < imageCenter.x && blueCentroid.x > imageLeftThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Left Sharp" << std::endl;
-            }
-            newSteering = 0.17f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        if (blueCentroid.x > imageLeftThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Left Sharpest" << std::endl;
-            }
-            newSteering = 0.225f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        // Yellow cones on the left
-        if (yellowCentroid.x > imageLeftThird.x && yellowCentroid.x < imageCenter.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right" << std::endl;
-            }
-            newSteering = -0.11f;
-            return newSteering; // Steer left to adjust for yellow cone moving towards center
-        }
-        if (yellowCentroid.x > imageCenter.x && yellowCentroid.x < imageRightThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right Sharp" << std::endl;
-            }
-            newSteering = -0.17f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
-        if (blueCentroid.x > imageRightThird.x)
-        {
-            if (VERBOSE)
-            {
-                std::cout << "Steering Right Sharpest" << std::endl;
-            }
-            newSteering = -0.225f;
-            return newSteering; // Steer right to adjust for blue cone moving towards center
-        }
+        std::cout << (isClockwise ? SteeringPolicy<TrackDirection::Clockwise>::name() : SteeringPolicy<TrackDirection::CounterClockwise>::name()) << std::endl;
+        std::cout << zone.label << std::endl;
     }
-
-    // If none of the conditions are met, no steering adjustment is needed
-    if (VERBOSE)
+    if (!zone.keep)
     {
-        std::cout << "No Steering Adjustment" << std::endl;
+        newSteering = zone.steering;
     }
     return newSteering;
 }
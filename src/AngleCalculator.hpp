@@ -4,19 +4,50 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
+#include "BlobExtractor.hpp"
+#include "VisualizationSink.hpp"
 
 class AngleCalculator
 {
 public:
     AngleCalculator();
+    AngleCalculator(const AngleCalculator &) = delete;
+    AngleCalculator &operator=(const AngleCalculator &) = delete;
     float CalculateSteeringAngle(cv::Mat &yellowInputImage, cv::Mat &blueInputImage, float &steeringWheelAngle, bool isClockwise, float maxSteering, float minSteering, bool VERBOSE);
+    // Same from already extracted blobs (FramePipeline::ProcessStreaming). imageSize is the size of the
+    // processed region; the blobs must come from its top imageSize.height - CROP_HEIGHT rows only.
+    float CalculateSteeringAngle(const std::vector<Blob> &yellow, const std::vector<Blob> &blue, const cv::Size &imageSize, float &steeringWheelAngle, bool isClockwise, float maxSteering, float minSteering, bool VERBOSE);
+    // First half of the mask version: extracts the blobs of the masks above the cropped area into
+    // yellowDetections() / blueDetections(), so they can be used before (or without) steering.
+    void ExtractBlobs(const cv::Mat &yellowInputImage, const cv::Mat &blueInputImage);
+    const std::vector<Blob> &yellowDetections() const { return yellowBlobs.blobs(); }
+    const std::vector<Blob> &blueDetections() const { return blueBlobs.blobs(); }
+
+    // Debug view; records are only built when a sink is set and due, so without one the steering
+    // path does no drawing at all.
+    void setVisualizationSink(VisualizationSink *sink) { visualizationSink = sink; }
+
+    // Height in pixels cropped from the bottom of the masks (the distracting area).
+    static constexpr int CROP_HEIGHT = 100;
+    // Contour area of the blobs that count as cones; smaller and larger ones are ignored.
+    static constexpr double MIN_CONE_AREA = 130.0;
+    static constexpr double MAX_CONE_AREA = 1000.0;
 
 private:
-    cv::Point calculateCentroid(const std::vector<std::vector<cv::Point>> &contours, const cv::Point &imageCenter);
+    float steerFromBlobs(const std::vector<Blob> &yellow, const std::vector<Blob> &blue, const cv::Size &imageSize, float steeringWheelAngle, bool isClockwise, float maxSteering, float minSteering, bool VERBOSE);
+    cv::Point calculateCentroid(const std::vector<Blob> &blobs, const std::vector<size_t> &selected, const cv::Point &imageCenter);
     float adjustSteering(float &newSteering, cv::Point &blueCentroid, cv::Point yellowCentroid, const cv::Point &imageCenter, const cv::Point &imageLeftThird, const cv::Point &imageRightThird, bool isClockwise, bool VERBOSE);
     float smoothSteering(float currentSteering, float alpha);
     static constexpr float steeringSensitivity = 0.1f; // Adjust sensitivity
     static constexpr float steeringThreshold = 0.05f;  // Minimum change required to adjust steering
+
+    // Kept between frames so their storage is reused instead of allocated on every call.
+    BlobExtractor blueBlobs;
+    BlobExtractor yellowBlobs;
+    std::vector<size_t> filteredBlueBlobs;   // Indices into blueBlobs.blobs()
+    std::vector<size_t> filteredYellowBlobs; // Indices into yellowBlobs.blobs()
+    VisualizationSink *visualizationSink{nullptr};
+    DetectionRecord detectionRecord;
 };
 
 #endif // ANGLE_CALCULATOR_HPP
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include "BinaryMask.hpp"
+
+BinaryMask::BinaryMask()
+    : bits(),
+      scratch()
+{
+}
+
+void BinaryMask::create(int maskRows, int maskCols)
+{
+    height = maskRows;
+    width = maskCols;
+    wordsPerRow = (static_cast<size_t>(maskCols) + 63) / 64;
+    const int tailBits = maskCols % 64;
+    lastWordMask = (tailBits == 0) ? ~uint64_t{0} : ((uint64_t{1} << tailBits) - 1);
+    // Only grows, so a mask that is reused for frames of the same size never reallocates.
+    bits.resize(static_cast<size_t>(maskRows) * wordsPerRow);
+}
+
+void BinaryMask::Pack(const cv::Mat &mask)
+{
+    CV_Assert(mask.type() == CV_8UC1);
+    create(mask.rows, mask.cols);
+    for (int y = 0; y < height; y++)
+    {
+        const uchar *src = mask.ptr<uchar>(y);
+        uint64_t *dst = row(y);
+        for (size_t w = 0; w < wordsPerRow; w++)
+        {
+            const int begin = static_cast<int>(w * 64);
+            const int end = std::min(begin + 64, width);
+            uint64_t word = 0;
+            for (int x = begin; x < end; x++)
+            {
+                word |= static_cast<uint64_t>(src[x] != 0) << (x - begin);
+            }
+            dst[w] = word;
+        }
+    }
+}
+
+void BinaryMask::Unpack(cv::Mat &mask) const
+{
+    mask.create(height, width, CV_8UC1);
+    for (int y = 0; y < height; y++)
+    {
+        const uint64_t *src = row(y);
+        uchar *dst = mask.ptr<uchar>(y);
+        for (int x = 0; x < width; x++)
+        {
+            // 0 - 1 = 0xff for set bits.
+            dst[x] = static_cast<uchar>(0 - static_cast<int>((src[x >> 6] >> (x & 63)) & 1));
+        }
+    }
+}
+
+void BinaryMask::shiftedRow(const uint64_t *src, uint64_t *left, uint64_t *right, bool fill) const
+{
+    const uint64_t fillWord = fill ? ~uint64_t{0} : 0;
+    for (size_t w = 0; w < wordsPerRow; w++)
+    {
+        const uint64_t previous = (w > 0) ? src[w - 1] : fillWord;
+        const uint64_t next = (w + 1 < wordsPerRow) ? src[w + 1] : fillWord;
+        left[w] = (src[w] << 1) | (previous >> 63);
+        right[w] = (src[w] >> 1) | (next << 63);
+    }
+    if (fill && wordsPerRow > 0)
+    {
+        // The right neighbour of the last pixel is a padding bit (0) unless the row fills the word.
+        right[wordsPerRow - 1] |= uint64_t{1} << ((width - 1) % 64);
+    }
+}
+
+void BinaryMask::Erode(const BinaryMask &src, BinaryMask &dst)
+{
+    dst.create(src.height, src.width);
+    if (src.wordsPerRow == 0)
+    {
+        return;
+    }
+    dst.scratch.resize(std::max(dst.scratch.size(), 2 * src.wordsPerRow));
+    uint64_t *left = dst.scratch.data();
+    uint64_t *right = left + src.wordsPerRow;
+    for (int y = 0; y < src.height; y++)
+    {
+        const uint64_t *centre = src.row(y);
+        const uint64_t *above = (y > 0) ? src.row(y - 1) : centre;
+        const uint64_t *below = (y + 1 < src.height) ? src.row(y + 1) : centre;
+        src.shiftedRow(centre, left, right, true);
+        uint64_t *out = dst.row(y);
+        for (size_t w = 0; w < src.wordsPerRow; w++)
+        {
+            out[w] = centre[w] & above[w] & below[w] & left[w] & right[w];
+        }
+        // Padding bits stay 0.
+        out[src.wordsPerRow - 1] &= src.lastWordMask;
+    }
+}
+
+void BinaryMask::Dilate(const BinaryMask &src, BinaryMask &dst)
+{
+    dst.create(src.height, src.width);
+    if (src.wordsPerRow == 0)
+    {
+        return;
+    }
+    dst.scratch.resize(std::max(dst.scratch.size(), 2 * src.wordsPerRow));
+    uint64_t *left = dst.scratch.data();
+    uint64_t *right = left + src.wordsPerRow;
+    for (int y = 0; y < src.height; y++)
+    {
+        const uint64_t *centre = src.row(y);
+        const uint64_t *above = (y > 0) ? src.row(y - 1) : centre;
+        const uint64_t *below = (y + 1 < src.height) ? src.row(y + 1) : centre;
+        src.shiftedRow(centre, left, right, false);
+        uint64_t *out = dst.row(y);
+        for (size_t w = 0; w < src.wordsPerRow; w++)
+        {
+            out[w] = centre[w] | above[w] | below[w] | left[w] | right[w];
+        }
+        out[src.wordsPerRow - 1] &= src.lastWordMask;
+    }
+}
+
+void BinaryMask::Open(const BinaryMask &src, BinaryMask &dst, BinaryMask &tmp)
+{
+    Erode(src, tmp);
+    Dilate(tmp, dst);
+}
+
+void BinaryMask::DilateSquare(const BinaryMask &src, BinaryMask &dst, int radius)
+{
+    dst.create(src.height, src.width);
+    if (src.wordsPerRow == 0)
+    {
+        return;
+    }
+
+    // Horizontal pass: OR of the row shifted by up to radius pixels either way.
+    const size_t words = src.wordsPerRow;
+    dst.scratch.resize(std::max(dst.scratch.size(), src.bits.size() + 4 * words));
+    uint64_t *horizontal = dst.scratch.data();
+    uint64_t *left = horizontal + src.bits.size();
+    uint64_t *right = left + words;
+    uint64_t *shiftedLeft = right + words;
+    uint64_t *shiftedRight = shiftedLeft + words;
+    for (int y = 0; y < src.height; y++)
+    {
+        const uint64_t *centre = src.row(y);
+        uint64_t *out = horizontal + static_cast<size_t>(y) * words;
+        std::copy(centre, centre + words, out);
+        std::copy(centre, centre + words, left);
+        std::copy(centre, centre + words, right);
+        for (int step = 0; step < radius; step++)
+        {
+            // Shifting the already shifted rows again moves them one more pixel.
+            src.shiftedRow(left, shiftedLeft, shiftedRight, false);
+            std::swap(left, shiftedLeft);
+            src.shiftedRow(right, shiftedLeft, shiftedRight, false);
+            std::swap(right, shiftedRight);
+            for (size_t w = 0; w < words; w++)
+            {
+                out[w] |= left[w] | right[w];
+            }
+        }
+        out[words - 1] &= src.lastWordMask;
+    }
+
+    // Vertical pass over the rows within radius that exist.
+    for (int y = 0; y < src.height; y++)
+    {
+        uint64_t *out = dst.row(y);
+        std::fill(out, out + words, 0);
+        const int first = std::max(0, y - radius);
+        const int last = std::min(src.height - 1, y + radius);
+        for (int r = first; r <= last; r++)
+        {
+            const uint64_t *in = horizontal + static_cast<size_t>(r) * words;
+            for (size_t w = 0; w < words; w++)
+            {
+                out[w] |= in[w];
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef BINARY_MASK_HPP
+#define BINARY_MASK_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+// A mask stored as one bit per pixel, 64 pixels per word, so the morphology of NoiseRemover
+// can be done with word-parallel shifts, ANDs and ORs instead of one byte per pixel.
+// Bit i of word w in a row is pixel 64 * w + i; the bits past the last column are always 0.
+//
+// As with OpenCV's defaults, pixels outside the image are ignored by all operations.
+class BinaryMask
+{
+public:
+    BinaryMask();
+
+    // Nonzero pixels of an 8-bit single channel mask become set bits.
+    void Pack(const cv::Mat &mask);
+    // Writes a 0/255 mask.
+    void Unpack(cv::Mat &mask) const;
+
+    int rows() const { return height; }
+    int cols() const { return width; }
+
+    // 3x3 cross (the 3x3 elliptical structuring element).
+    static void Erode(const BinaryMask &src, BinaryMask &dst);
+    static void Dilate(const BinaryMask &src, BinaryMask &dst);
+    // src and dst must be different masks.
+    // Erode followed by dilate; tmp holds the eroded mask.
+    static void Open(const BinaryMask &src, BinaryMask &dst, BinaryMask &tmp);
+    // Square of side 2 * radius + 1. Thresholding a 5x5 GaussianBlur of a 0/255 mask at > 0 is
+    // the same as DilateSquare with radius 2, as every weight of that kernel is positive.
+    static void DilateSquare(const BinaryMask &src, BinaryMask &dst, int radius);
+
+private:
+    void create(int maskRows, int maskCols);
+    const uint64_t *row(int y) const { return &bits[static_cast<size_t>(y) * wordsPerRow]; }
+    uint64_t *row(int y) { return &bits[static_cast<size_t>(y) * wordsPerRow]; }
+    // Pixel x - 1 (left) and x + 1 (right) moved to position x; fill is used for the missing pixel.
+    void shiftedRow(const uint64_t *src, uint64_t *left, uint64_t *right, bool fill) const;
+
+    int height{0};
+    int width{0};
+    size_t wordsPerRow{0};
+    // Valid bits of the last word of a row.
+    uint64_t lastWordMask{0};
+    std::vector<uint64_t> bits;
+    // Row buffers of the operations writing into this mask, kept to avoid per-frame allocations.
+    std::vector<uint64_t> scratch;
+};
+
+#endif // BINARY_MASK_HPP
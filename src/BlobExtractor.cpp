@@ -0,0 +1,301 @@
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include "BlobExtractor.hpp"
+
+BlobExtractor::BlobExtractor()
+    : previousRuns(),
+      currentRuns(),
+      previousLabels(),
+      currentLabels(),
+      parent(),
+      stats(),
+      output(),
+      rootIndex(),
+      firstRowIndex(),
+      lastRowIndex()
+{
+    // Typical frames have a few hundred runs that start a component; avoid growing on the car.
+    parent.reserve(1024);
+    stats.reserve(1024);
+    output.reserve(256);
+}
+
+void BlobExtractor::Extract(const cv::Mat &mask)
+{
+    CV_Assert(mask.type() == CV_8UC1);
+    Begin(mask.cols);
+    for (int row = 0; row < mask.rows; row++)
+    {
+        PushRow(mask.ptr<uchar>(row));
+    }
+    End();
+}
+
+void BlobExtractor::Begin(int rowWidth, int firstRow, int firstColumn)
+{
+    width = rowWidth;
+    firstX = firstColumn;
+    firstY = firstRow;
+    y = firstRow;
+    previousRuns.clear();
+    currentRuns.clear();
+    previousLabels.assign(static_cast<size_t>(width), -1);
+    currentLabels.assign(static_cast<size_t>(width), -1);
+    parent.clear();
+    stats.clear();
+    output.clear();
+    firstRowIndex.assign(static_cast<size_t>(width), -1);
+    lastRowIndex.assign(static_cast<size_t>(width), -1);
+}
+
+int BlobExtractor::newLabel(int row, const Run &run)
+{
+    const int label = static_cast<int>(parent.size());
+    parent.push_back(label);
+    stats.push_back(Accumulator{0, 0, 0, run.begin, run.end, row, row, 0});
+    return label;
+}
+
+int BlobExtractor::find(int label)
+{
+    while (parent[static_cast<size_t>(label)] != label)
+    {
+        // Path halving.
+        parent[static_cast<size_t>(label)] = parent[static_cast<size_t>(parent[static_cast<size_t>(label)])];
+        label = parent[static_cast<size_t>(label)];
+    }
+    return label;
+}
+
+int BlobExtractor::unite(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    // The smaller label stays the root, so the output is in raster order of the first pixel.
+    if (a < b)
+    {
+        parent[static_cast<size_t>(b)] = a;
+        return a;
+    }
+    parent[static_cast<size_t>(a)] = b;
+    return b;
+}
+
+void BlobExtractor::PushRow(const uchar *row, uchar classBits)
+{
+    std::swap(previousRuns, currentRuns);
+    std::swap(previousLabels, currentLabels);
+    currentRuns.clear();
+
+    size_t overlap = 0;
+    int x = 0;
+    while (x < width)
+    {
+        if ((row[x] & classBits) == 0)
+        {
+            currentLabels[static_cast<size_t>(x)] = -1;
+            x++;
+            continue;
+        }
+
+        Run run{x, x, -1};
+        while (run.end + 1 < width && (row[run.end + 1] & classBits) != 0)
+        {
+            run.end++;
+        }
+
+        // 8-connectivity: a run of the previous row touches this one if it reaches one pixel past either end.
+        while (overlap < previousRuns.size() && previousRuns[overlap].end < run.begin - 1)
+        {
+            overlap++;
+        }
+        for (size_t i = overlap; i < previousRuns.size() && previousRuns[i].begin <= run.end + 1; i++)
+        {
+            run.label = (run.label < 0) ? find(previousRuns[i].label) : unite(run.label, previousRuns[i].label);
+        }
+        if (run.label < 0)
+        {
+            run.label = newLabel(y, run);
+        }
+
+        Accumulator &s = stats[static_cast<size_t>(run.label)];
+        const int64_t length = run.end - run.begin + 1;
+        s.pixels += length;
+        s.sumX += (static_cast<int64_t>(run.begin) + run.end) * length / 2;
+        s.sumY += static_cast<int64_t>(y) * length;
+        s.minX = std::min(s.minX, run.begin);
+        s.maxX = std::max(s.maxX, run.end);
+        s.maxY = y;
+        std::fill(currentLabels.begin() + run.begin, currentLabels.begin() + run.end + 1, run.label);
+        currentRuns.push_back(run);
+        x = run.end + 1;
+    }
+    if (y == firstY)
+    {
+        firstRowIndex = currentLabels;
+    }
+
+    // 2x2 windows spanning the previous and the current row. Three or four set pixels in a window
+    // are always 8-connected, so any of their labels names the component.
+    if (y > firstY)
+    {
+        for (int wx = 0; wx + 1 < width; wx++)
+        {
+            const int labels[4] = {previousLabels[static_cast<size_t>(wx)], previousLabels[static_cast<size_t>(wx + 1)],
+                                   currentLabels[static_cast<size_t>(wx)], currentLabels[static_cast<size_t>(wx + 1)]};
+            const int set = (labels[0] >= 0) + (labels[1] >= 0) + (labels[2] >= 0) + (labels[3] >= 0);
+            if (set >= 3)
+            {
+                const int label = (labels[0] >= 0) ? labels[0] : labels[1];
+                stats[static_cast<size_t>(label)].twiceContourArea += (set == 4) ? 2 : 1;
+            }
+        }
+    }
+    y++;
+}
+
+void BlobExtractor::End()
+{
+    rootIndex.resize(stats.size());
+    // Fold the statistics of merged labels into their root; roots always have the smaller index.
+    for (size_t label = 0; label < stats.size(); label++)
+    {
+        const size_t root = static_cast<size_t>(find(static_cast<int>(label)));
+        if (root != label)
+        {
+            Accumulator &r = stats[root];
+            const Accumulator &s = stats[label];
+            r.pixels += s.pixels;
+            r.sumX += s.sumX;
+            r.sumY += s.sumY;
+            r.minX = std::min(r.minX, s.minX);
+            r.maxX = std::max(r.maxX, s.maxX);
+            r.minY = std::min(r.minY, s.minY);
+            r.maxY = std::max(r.maxY, s.maxY);
+            r.twiceContourArea += s.twiceContourArea;
+        }
+    }
+    for (size_t label = 0; label < stats.size(); label++)
+    {
+        if (parent[label] == static_cast<int>(label))
+        {
+            const Accumulator &s = stats[label];
+            rootIndex[label] = static_cast<int>(output.size());
+            output.push_back(Blob{static_cast<int>(s.pixels), 0.5 * static_cast<double>(s.twiceContourArea),
+                                  cv::Rect(s.minX + firstX, s.minY, s.maxX - s.minX + 1, s.maxY - s.minY + 1),
+                                  static_cast<double>(s.sumX + s.pixels * firstX), static_cast<double>(s.sumY)});
+        }
+    }
+
+    // firstRowIndex holds the labels of the first row until here.
+    for (size_t x = 0; x < firstRowIndex.size(); x++)
+    {
+        const int first = firstRowIndex[x];
+        const int last = (y > firstY) ? currentLabels[x] : -1;
+        firstRowIndex[x] = (first >= 0) ? rootIndex[static_cast<size_t>(find(first))] : -1;
+        lastRowIndex[x] = (last >= 0) ? rootIndex[static_cast<size_t>(find(last))] : -1;
+    }
+}
+
+BlobStripeMerger::BlobStripeMerger()
+    : offsets(),
+      parent(),
+      twiceBoundaryArea(),
+      parts()
+{
+}
+
+int BlobStripeMerger::find(int index)
+{
+    while (parent[static_cast<size_t>(index)] != index)
+    {
+        parent[static_cast<size_t>(index)] = parent[static_cast<size_t>(parent[static_cast<size_t>(index)])];
+        index = parent[static_cast<size_t>(index)];
+    }
+    return index;
+}
+
+void BlobStripeMerger::Merge(const std::vector<const BlobExtractor *> &stripes, std::vector<Blob> &merged)
+{
+    // Blobs of all stripes in one list: stripes in order, each in raster order of the first
+    // pixel, so the list index is the raster order of the first pixel over the whole mask.
+    parts.clear();
+    offsets.clear();
+    for (const BlobExtractor *stripe : stripes)
+    {
+        offsets.push_back(parts.size());
+        parts.insert(parts.end(), stripe->blobs().begin(), stripe->blobs().end());
+    }
+    parent.resize(parts.size());
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        parent[i] = static_cast<int>(i);
+    }
+    twiceBoundaryArea.assign(parts.size(), 0);
+
+    for (size_t k = 0; k + 1 < stripes.size(); k++)
+    {
+        const std::vector<int> &above = stripes[k]->lastRowBlobs();
+        const std::vector<int> &below = stripes[k + 1]->firstRowBlobs();
+        const int width = static_cast<int>(std::min(above.size(), below.size()));
+        const int aboveOffset = static_cast<int>(offsets[k]);
+        const int belowOffset = static_cast<int>(offsets[k + 1]);
+        for (int x = 0; x < width; x++)
+        {
+            const int a = above[static_cast<size_t>(x)];
+            if (a < 0)
+            {
+                continue;
+            }
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++)
+            {
+                const int b = below[static_cast<size_t>(nx)];
+                if (b >= 0)
+                {
+                    // The smaller index stays the root, as in BlobExtractor::unite.
+                    const int rootA = find(aboveOffset + a);
+                    const int rootB = find(belowOffset + b);
+                    parent[static_cast<size_t>(std::max(rootA, rootB))] = std::min(rootA, rootB);
+                }
+            }
+        }
+        // 2x2 windows spanning the boundary are not seen by either stripe.
+        for (int wx = 0; wx + 1 < width; wx++)
+        {
+            const int window[4] = {above[static_cast<size_t>(wx)], above[static_cast<size_t>(wx + 1)],
+                                   below[static_cast<size_t>(wx)], below[static_cast<size_t>(wx + 1)]};
+            const int set = (window[0] >= 0) + (window[1] >= 0) + (window[2] >= 0) + (window[3] >= 0);
+            if (set >= 3)
+            {
+                const int index = aboveOffset + ((window[0] >= 0) ? window[0] : window[1]);
+                twiceBoundaryArea[static_cast<size_t>(index)] += (set == 4) ? 2 : 1;
+            }
+        }
+    }
+
+    // Fold every part into its root; roots always have the smaller index.
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        const size_t root = static_cast<size_t>(find(static_cast<int>(i)));
+        if (root != i)
+        {
+            Blob &r = parts[root];
+            const Blob &s = parts[i];
+            r.area += s.area;
+            r.contourArea += s.contourArea;
+            r.boundingBox |= s.boundingBox;
+            r.m10 += s.m10;
+            r.m01 += s.m01;
+            twiceBoundaryArea[root] += twiceBoundaryArea[i];
+        }
+    }
+    merged.clear();
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        if (parent[i] == static_cast<int>(i))
+        {
+            merged.push_back(parts[i]);
+            merged.back().contourArea += 0.5 * static_cast<double>(twiceBoundaryArea[i]);
+        }
+    }
+}
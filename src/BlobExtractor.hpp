@@ -0,0 +1,108 @@
+#ifndef BLOB_EXTRACTOR_HPP
+#define BLOB_EXTRACTOR_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+// One 8-connected component of a mask (nonzero pixels, same connectivity as cv::findContours).
+struct Blob
+{
+    int area;           // Number of pixels, i.e. m00 of the region.
+    double contourArea; // cv::contourArea of the outer contour; exact for blobs without holes.
+    cv::Rect boundingBox;
+    double m10; // Sum of the x coordinates of the pixels.
+    double m01; // Sum of the y coordinates of the pixels.
+
+    cv::Point2d centroid() const { return cv::Point2d(m10 / area, m01 / area); }
+};
+
+// Connected component extraction in a single raster scan, as a replacement for findContours
+// followed by contourArea / boundingRect / moments on every contour. Runs of foreground pixels
+// are labelled against the runs of the previous row with union-find, and the statistics are
+// accumulated on the way, so only two rows of labels are kept besides the output.
+//
+// Rows can be pushed one at a time (Begin / PushRow / End) so the extractor can sit at the end
+// of a row-streaming pipeline, or a whole mask can be passed to Extract. Horizontal stripes of
+// one mask can be extracted separately and joined with BlobStripeMerger.
+class BlobExtractor
+{
+public:
+    BlobExtractor();
+
+    void Extract(const cv::Mat &mask);
+
+    // firstRow and firstColumn are the coordinates of the first pixel of the first pushed row in
+    // the blob statistics; firstRowBlobs / lastRowBlobs are indexed from 0 regardless.
+    void Begin(int width, int firstRow = 0, int firstColumn = 0);
+    // Pixels with any of classBits set are foreground, so a row of a class-bit mask can be passed as is.
+    void PushRow(const uchar *row, uchar classBits = 0xff);
+    void End();
+
+    // Components in raster order of their first pixel; valid until the next Begin / Extract.
+    const std::vector<Blob> &blobs() const { return output; }
+    // Index into blobs() of every pixel of the first and of the last pushed row, -1 for background.
+    const std::vector<int> &firstRowBlobs() const { return firstRowIndex; }
+    const std::vector<int> &lastRowBlobs() const { return lastRowIndex; }
+
+private:
+    struct Run
+    {
+        int begin; // First pixel.
+        int end;   // Last pixel (inclusive).
+        int label;
+    };
+    struct Accumulator
+    {
+        int64_t pixels;
+        int64_t sumX;
+        int64_t sumY;
+        int minX, maxX, minY, maxY;
+        // Twice the area of the polygon through the boundary pixel centres: every 2x2 window with
+        // all four pixels set adds 2, with three set 1 (a half square cut along the diagonal).
+        int64_t twiceContourArea;
+    };
+
+    int newLabel(int y, const Run &run);
+    int find(int label);
+    int unite(int a, int b);
+
+    int width{0};
+    int firstX{0};
+    int firstY{0};
+    int y{0};
+    std::vector<Run> previousRuns;
+    std::vector<Run> currentRuns;
+    std::vector<int> previousLabels; // Label per pixel of the previous row, -1 for background.
+    std::vector<int> currentLabels;
+    std::vector<int> parent;
+    std::vector<Accumulator> stats;
+    std::vector<Blob> output;
+    std::vector<int> rootIndex; // Output index of every root label.
+    std::vector<int> firstRowIndex;
+    std::vector<int> lastRowIndex;
+};
+
+// Joins the blobs of horizontal stripes of one mask that were extracted by separate
+// BlobExtractors (e.g. on different threads) into the blobs of the whole mask. Components that
+// touch across a stripe boundary are united with union-find, and the 2x2 windows spanning the
+// boundary are added to their contour area, so the result is identical to one extraction of
+// the whole mask, including the order.
+class BlobStripeMerger
+{
+public:
+    BlobStripeMerger();
+
+    // stripes must be in top-to-bottom order and cover consecutive rows.
+    void Merge(const std::vector<const BlobExtractor *> &stripes, std::vector<Blob> &merged);
+
+private:
+    int find(int index);
+
+    std::vector<size_t> offsets; // Index of the first blob of every stripe in parts.
+    std::vector<int> parent;
+    std::vector<int64_t> twiceBoundaryArea;
+    std::vector<Blob> parts;
+};
+
+#endif // BLOB_EXTRACTOR_HPP
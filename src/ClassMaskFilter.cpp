@@ -0,0 +1,134 @@
+#include <algorithm>
+#include "ClassMaskFilter.hpp"
+
+template <typename T>
+ClassMaskFilter<T>::ClassMaskFilter()
+    : horizontal(),
+      square(),
+      eroded(),
+      output()
+{
+}
+
+template <typename T>
+void ClassMaskFilter<T>::Begin(int width, int height)
+{
+    cols = width;
+    rows = height;
+    nextStep = 0;
+    // resize() keeps the capacity, so the buffers are only allocated for the first (or a wider) image.
+    horizontal.resize(5 * static_cast<size_t>(width));
+    square.resize(3 * static_cast<size_t>(width));
+    eroded.resize(3 * static_cast<size_t>(width));
+    output.resize(static_cast<size_t>(width));
+}
+
+template <typename T>
+int ClassMaskFilter<T>::PushRow(const T *row)
+{
+    return step(row);
+}
+
+template <typename T>
+int ClassMaskFilter<T>::Flush()
+{
+    // With fewer rows than DELAY the first steps do not produce a row yet.
+    while (nextStep < rows + DELAY)
+    {
+        const int ready = step(nullptr);
+        if (ready >= 0)
+        {
+            return ready;
+        }
+    }
+    return -1;
+}
+
+template <typename T>
+int ClassMaskFilter<T>::step(const T *row)
+{
+    // Every stage works on the last row its inputs are complete for.
+    const int current = nextStep++;
+
+    const int yHorizontal = current;
+    if (row != nullptr && yHorizontal < rows)
+    {
+        T *dst = horizontalRow(yHorizontal);
+        for (int x = 0; x < cols; x++)
+        {
+            T value = row[x];
+            for (int dx = std::max(0, x - 2); dx <= std::min(cols - 1, x + 2); dx++)
+            {
+                value = static_cast<T>(value | row[dx]);
+            }
+            dst[x] = value;
+        }
+    }
+
+    const int ySquare = current - 2;
+    if (ySquare >= 0 && ySquare < rows)
+    {
+        T *dst = squareRow(ySquare);
+        std::fill(dst, dst + cols, T{0});
+        for (int y = std::max(0, ySquare - 2); y <= std::min(rows - 1, ySquare + 2); y++)
+        {
+            const T *src = horizontalRow(y);
+            for (int x = 0; x < cols; x++)
+            {
+                dst[x] = static_cast<T>(dst[x] | src[x]);
+            }
+        }
+    }
+
+    // 3x3 cross erode; missing rows and columns are ignored.
+    const int yEroded = current - 3;
+    if (yEroded >= 0 && yEroded < rows)
+    {
+        const T *centre = squareRow(yEroded);
+        const T *above = (yEroded > 0) ? squareRow(yEroded - 1) : centre;
+        const T *below = (yEroded + 1 < rows) ? squareRow(yEroded + 1) : centre;
+        T *dst = erodedRow(yEroded);
+        for (int x = 0; x < cols; x++)
+        {
+            T value = static_cast<T>(centre[x] & above[x] & below[x]);
+            if (x > 0)
+            {
+                value = static_cast<T>(value & centre[x - 1]);
+            }
+            if (x + 1 < cols)
+            {
+                value = static_cast<T>(value & centre[x + 1]);
+            }
+            dst[x] = value;
+        }
+    }
+
+    // 3x3 cross dilate into the output row.
+    const int yOutput = current - DELAY;
+    if (yOutput < 0 || yOutput >= rows)
+    {
+        return -1;
+    }
+    const T *centre = erodedRow(yOutput);
+    const T *above = (yOutput > 0) ? erodedRow(yOutput - 1) : centre;
+    const T *below = (yOutput + 1 < rows) ? erodedRow(yOutput + 1) : centre;
+    T *dst = output.data();
+    for (int x = 0; x < cols; x++)
+    {
+        T value = static_cast<T>(centre[x] | above[x] | below[x]);
+        if (x > 0)
+        {
+            value = static_cast<T>(value | centre[x - 1]);
+        }
+        if (x + 1 < cols)
+        {
+            value = static_cast<T>(value | centre[x + 1]);
+        }
+        dst[x] = value;
+    }
+    return yOutput;
+}
+
+template class ClassMaskFilter<uint8_t>;
+template class ClassMaskFilter<uint16_t>;
+template class ClassMaskFilter<int32_t>;
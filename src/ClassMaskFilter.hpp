@@ -0,0 +1,49 @@
+#ifndef CLASS_MASK_FILTER_HPP
+#define CLASS_MASK_FILTER_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Row-streaming noise removal on class-bit masks (bit k of a pixel set if it belongs to cone
+// class k). Bitwise OR is a dilation and bitwise AND an erosion of every class at once, so all
+// classes go through the stages of NoiseRemover together:
+//   5x5 OR (what is left of the 5x5 GaussianBlur when only nonzero matters), 3x3 cross AND
+//   (erode), 3x3 cross OR (dilate).
+// Only a few rows of every stage are kept, so the memory use grows with the width of the image,
+// not its area. Pixels outside the image are ignored, as with OpenCV's defaults.
+//
+// Instantiated for uint8_t, uint16_t and int32_t (8, 16 and 32 classes).
+template <typename T>
+class ClassMaskFilter
+{
+public:
+    // Output rows lag the input by this many rows.
+    static constexpr int DELAY = 4;
+
+    ClassMaskFilter();
+
+    void Begin(int width, int rows);
+    // Feeds the next input row. Returns the index of the output row that became ready, or -1.
+    int PushRow(const T *row);
+    // Once every row was pushed, call until it returns -1 to get the remaining output rows.
+    int Flush();
+
+    // The row returned by the last PushRow / Flush; valid until the next call.
+    const T *outputRow() const { return output.data(); }
+
+private:
+    int step(const T *row);
+    T *horizontalRow(int y) { return &horizontal[static_cast<size_t>(y % 5) * static_cast<size_t>(cols)]; }
+    T *squareRow(int y) { return &square[static_cast<size_t>(y % 3) * static_cast<size_t>(cols)]; }
+    T *erodedRow(int y) { return &eroded[static_cast<size_t>(y % 3) * static_cast<size_t>(cols)]; }
+
+    int cols{0};
+    int rows{0};
+    int nextStep{0};
+    std::vector<T> horizontal; // 5 rows after the horizontal part of the 5x5 OR.
+    std::vector<T> square;     // 3 rows after the vertical part.
+    std::vector<T> eroded;     // 3 eroded rows.
+    std::vector<T> output;
+};
+
+#endif // CLASS_MASK_FILTER_HPP
@@ -0,0 +1,98 @@
+#include "ColorLut.hpp"
+#include "HsvConversion.hpp"
+
+ColorLut::ColorLut()
+    : table(static_cast<size_t>(1) << 22, 0),
+      target()
+{
+}
+
+void ColorLut::Update(const HsvThresholds &thresholds)
+{
+    uint8_t changed = 0;
+    if (!initialized)
+    {
+        changed = BLUE | YELLOW;
+        initialized = true;
+    }
+    else
+    {
+        changed |= (thresholds.blue != target.blue) ? BLUE : 0;
+        changed |= (thresholds.yellow != target.yellow) ? YELLOW : 0;
+    }
+
+    if (changed != 0)
+    {
+        target = thresholds;
+        pendingClasses = static_cast<uint8_t>(pendingClasses | changed);
+        // Slabs already rebuilt were built with the old thresholds, start over.
+        nextSlab = 0;
+    }
+}
+
+bool ColorLut::RebuildStep(int maxSlabs)
+{
+    for (int i = 0; i < maxSlabs && pendingClasses != 0; i++)
+    {
+        rebuildSlab(nextSlab);
+        nextSlab++;
+        if (nextSlab == 256)
+        {
+            pendingClasses = 0;
+            nextSlab = 0;
+        }
+    }
+    return ready();
+}
+
+void ColorLut::rebuildSlab(int b)
+{
+    const HsvConversion &hsv = HsvConversion::instance();
+
+    // Bits of the classes that are not pending keep their current value.
+    uint8_t keepMask = 0;
+    for (int shift = 0; shift < 8; shift += 2)
+    {
+        keepMask = static_cast<uint8_t>(keepMask | ((~pendingClasses & 3) << shift));
+    }
+
+    uint8_t *slab = table.data() + (static_cast<size_t>(b) << 14);
+    for (int g = 0; g < 256; g++)
+    {
+        for (int r = 0; r < 256; r += 4)
+        {
+            uint8_t packed = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                int h, s, v;
+                hsv.toHsv(b, g, r + k, h, s, v);
+                const uint8_t code = static_cast<uint8_t>((target.blue.contains(h, s, v) ? BLUE : 0) |
+                                                          (target.yellow.contains(h, s, v) ? YELLOW : 0));
+                packed = static_cast<uint8_t>(packed | (code << (k * 2)));
+            }
+            uint8_t &entry = slab[(g << 6) | (r >> 2)];
+            entry = static_cast<uint8_t>((entry & keepMask) | (packed & ~keepMask));
+        }
+    }
+    rebuiltSlabs++;
+}
+
+void ColorLut::Classify(const cv::Mat &bgrFrame, cv::Mat &blueMask, cv::Mat &yellowMask) const
+{
+    blueMask.create(bgrFrame.rows, bgrFrame.cols, CV_8UC1);
+    yellowMask.create(bgrFrame.rows, bgrFrame.cols, CV_8UC1);
+
+    const int channels = bgrFrame.channels();
+    for (int y = 0; y < bgrFrame.rows; y++)
+    {
+        const uchar *src = bgrFrame.ptr<uchar>(y);
+        uchar *blueRow = blueMask.ptr<uchar>(y);
+        uchar *yellowRow = yellowMask.ptr<uchar>(y);
+        for (int x = 0; x < bgrFrame.cols; x++, src += channels)
+        {
+            const uint8_t code = classify(src[0], src[1], src[2]);
+            blueRow[x] = (code & BLUE) ? 255 : 0;
+            yellowRow[x] = (code & YELLOW) ? 255 : 0;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef COLOR_LUT_HPP
+#define COLOR_LUT_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+#include "HsvColorSeparator.hpp"
+
+// Precomputed colour classifier: a 2-bit class code for each of the 2^24 BGR colours (4 MB),
+// so classifying a pixel is a single table lookup instead of an HSV conversion plus range
+// checks. The table is exact, i.e. it gives the same masks as cvtColor + inRange.
+//
+// When a threshold changes only the bit plane of that colour is rebuilt, in slabs of 65536
+// colours (one blue value each), so the work can be spread over several frames.
+class ColorLut
+{
+public:
+    enum ClassBits : uint8_t
+    {
+        BLUE = 1,
+        YELLOW = 2
+    };
+
+    ColorLut();
+
+    // Schedules a rebuild of the class planes whose thresholds differ from the ones the table holds.
+    void Update(const HsvThresholds &thresholds);
+    // Rebuilds at most maxSlabs of the 256 slabs. Returns true once the table is complete.
+    bool RebuildStep(int maxSlabs);
+    bool ready() const { return pendingClasses == 0; }
+
+    inline uint8_t classify(int b, int g, int r) const
+    {
+        const uint32_t index = (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(r);
+        return static_cast<uint8_t>((table[index >> 2] >> ((index & 3) * 2)) & 3);
+    }
+
+    // Writes 0/255 masks for a BGR or BGRA frame. Only valid when ready().
+    void Classify(const cv::Mat &bgrFrame, cv::Mat &blueMask, cv::Mat &yellowMask) const;
+
+    uint64_t slabsRebuilt() const { return rebuiltSlabs; }
+
+private:
+    void rebuildSlab(int b);
+
+    std::vector<uint8_t> table;
+    HsvThresholds target;
+    uint8_t pendingClasses{BLUE | YELLOW};
+    int nextSlab{0};
+    bool initialized{false};
+    uint64_t rebuiltSlabs{0};
+};
+
+#endif // COLOR_LUT_HPP
@@ -3,6 +3,7 @@
 HsvColorSeparator colorSeparator;
 NoiseRemover noiseRemover;
 ContourFinder contourFinder;
+ParameterStore parameterStore(HsvColorSeparator::defaultThresholds());
 
 
 int minContourArea = 100;
@@ -4,10 +4,13 @@
 #include "HsvColorSeparator.hpp"
 #include "NoiseRemover.hpp"
 #include "ContourFinder.hpp"
+#include "ParameterStore.hpp"
 
 extern HsvColorSeparator colorSeparator;
 extern NoiseRemover noiseRemover;
 extern ContourFinder contourFinder;
+// Thresholds tuned through the debug UI; published by its thread, read once per frame.
+extern ParameterStore parameterStore;
 
 extern int minContourArea;
 extern int maxContourArea;
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include "AngleCalculator.hpp"
+#include "ClassMaskFilter.hpp"
+#include "ConeTracker.hpp"
+
+ConeTracker::ConeTracker(int fullSearchInterval)
+    : interval(std::max(1, fullSearchInterval)),
+      area(),
+      blueTracks(),
+      yellowTracks(),
+      previousTracks(),
+      windows(),
+      used(),
+      blueMatching(),
+      yellowMatching()
+{
+}
+
+void ConeTracker::Reset()
+{
+    blueTracks.clear();
+    yellowTracks.clear();
+    framesSinceFullSearch = 0;
+}
+
+void ConeTracker::Process(FramePipeline &pipeline, const cv::Rect &region, int blobRows)
+{
+    blobRows = std::max(0, std::min(blobRows, region.height));
+    area = cv::Size(region.width, blobRows);
+    const uint64_t pixelsBefore = pipeline.streamedPixels();
+    pixelsFullSearch += static_cast<uint64_t>(region.width) * static_cast<uint64_t>(std::min(region.height, blobRows + ClassMaskFilter<uint8_t>::DELAY));
+    frames++;
+
+    predict(blueTracks);
+    predict(yellowTracks);
+
+    bool tracked = false;
+    if (framesSinceFullSearch + 1 < interval && (!blueTracks.empty() || !yellowTracks.empty()))
+    {
+        windows.clear();
+        for (const std::vector<Track> *tracks : {&blueTracks, &yellowTracks})
+        {
+            for (const Track &track : *tracks)
+            {
+                windows.push_back(track.window);
+            }
+        }
+        FramePipeline::mergeWindows(windows);
+        pipeline.ProcessWindows(region, windows);
+        pixelsInWindows += pipeline.streamedPixels() - pixelsBefore;
+        // Both colours have to be matched before either one is updated; otherwise restart would
+        // apply the blobs of this frame a second time to the colour that was followed.
+        tracked = match(blueTracks, pipeline.blueBlobs(), blueMatching);
+        tracked = match(yellowTracks, pipeline.yellowBlobs(), yellowMatching) && tracked;
+        if (tracked)
+        {
+            follow(blueTracks, pipeline.blueBlobs(), blueMatching);
+            follow(yellowTracks, pipeline.yellowBlobs(), yellowMatching);
+            framesSinceFullSearch++;
+        }
+        else
+        {
+            fallbackSearches++;
+        }
+    }
+    else
+    {
+        scheduledSearches++;
+    }
+
+    if (!tracked)
+    {
+        pipeline.ProcessCoarseToFine(region, blobRows, coarseLevel);
+        restart(blueTracks, pipeline.blueBlobs());
+        restart(yellowTracks, pipeline.yellowBlobs());
+        framesSinceFullSearch = 0;
+    }
+    pixelsSegmented += pipeline.streamedPixels() - pixelsBefore;
+}
+
+void ConeTracker::predict(std::vector<Track> &tracks)
+{
+    const cv::Rect bounds(cv::Point(0, 0), area);
+    size_t kept = 0;
+    for (Track &track : tracks)
+    {
+        const cv::Point shift(static_cast<int>(std::lround(track.velocity.x)), static_cast<int>(std::lround(track.velocity.y)));
+        track.predicted = track.box + shift;
+        const int marginX = WINDOW_MARGIN + static_cast<int>(std::ceil(std::abs(track.velocity.x)));
+        const int marginY = WINDOW_MARGIN + static_cast<int>(std::ceil(std::abs(track.velocity.y)));
+        track.window = cv::Rect(track.predicted.x - marginX, track.predicted.y - marginY,
+                                track.predicted.width + 2 * marginX, track.predicted.height + 2 * marginY) &
+                       bounds;
+        // A cone predicted to be completely out of the region has left the view.
+        if (track.window.area() > 0)
+        {
+            tracks[kept++] = track;
+        }
+    }
+    tracks.erase(tracks.begin() + static_cast<std::ptrdiff_t>(kept), tracks.end());
+}
+
+bool ConeTracker::match(const std::vector<Track> &tracks, const std::vector<Blob> &blobs, Matching &matching)
+{
+    const cv::Rect bounds(cv::Point(0, 0), area);
+    std::vector<bool> &claimed = matching.used;
+    claimed.assign(blobs.size(), false);
+    matching.matches.assign(tracks.size(), -1);
+    bool lost = false;
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        const Track &track = tracks[t];
+        const cv::Point2d expected = track.centroid + track.velocity;
+        int best = -1;
+        double bestDistance = 0.0;
+        for (size_t i = 0; i < blobs.size(); i++)
+        {
+            const cv::Point2d centroid = blobs[i].centroid();
+            if (claimed[i] || !isCone(blobs[i]) || !track.window.contains(cv::Point(static_cast<int>(centroid.x), static_cast<int>(centroid.y))))
+            {
+                continue;
+            }
+            const double distance = cv::norm(centroid - expected);
+            if (best < 0 || distance < bestDistance)
+            {
+                best = static_cast<int>(i);
+                bestDistance = distance;
+            }
+        }
+
+        predictions++;
+        if (best >= 0 && !clipped(blobs[static_cast<size_t>(best)]))
+        {
+            hits++;
+            claimed[static_cast<size_t>(best)] = true;
+            matching.matches[t] = best;
+        }
+        else if (best >= 0 || (track.predicted & bounds) == track.predicted)
+        {
+            // Cut off by the window, or gone although it should still be in view.
+            lost = true;
+        }
+        // Otherwise the cone is leaving the region at an edge and the track is dropped.
+    }
+    // A cone cut by a window edge that no track claimed would reach the steering path as a fragment.
+    for (size_t i = 0; i < blobs.size() && !lost; i++)
+    {
+        lost = !claimed[i] && isCone(blobs[i]) && clipped(blobs[i]);
+    }
+    return !lost;
+}
+
+void ConeTracker::follow(std::vector<Track> &tracks, const std::vector<Blob> &blobs, const Matching &matching)
+{
+    size_t kept = 0;
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        if (matching.matches[t] >= 0)
+        {
+            update(tracks[t], blobs[static_cast<size_t>(matching.matches[t])]);
+            tracks[kept++] = tracks[t];
+        }
+    }
+    tracks.erase(tracks.begin() + static_cast<std::ptrdiff_t>(kept), tracks.end());
+    // Cones that came into one of the windows.
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        if (!matching.used[i] && isCone(blobs[i]))
+        {
+            tracks.push_back(Track{blobs[i].centroid(), cv::Point2d(0.0, 0.0), blobs[i].boundingBox, cv::Rect(), cv::Rect()});
+        }
+    }
+}
+
+void ConeTracker::restart(std::vector<Track> &tracks, const std::vector<Blob> &blobs)
+{
+    previousTracks.swap(tracks);
+    tracks.clear();
+    used.assign(previousTracks.size(), false);
+    for (const Blob &blob : blobs)
+    {
+        if (!isCone(blob))
+        {
+            continue;
+        }
+        const cv::Point2d centroid = blob.centroid();
+        int best = -1;
+        double bestDistance = 0.0;
+        for (size_t t = 0; t < previousTracks.size(); t++)
+        {
+            const Track &track = previousTracks[t];
+            if (used[t] || !track.window.contains(cv::Point(static_cast<int>(centroid.x), static_cast<int>(centroid.y))))
+            {
+                continue;
+            }
+            const double distance = cv::norm(centroid - (track.centroid + track.velocity));
+            if (best < 0 || distance < bestDistance)
+            {
+                best = static_cast<int>(t);
+                bestDistance = distance;
+            }
+        }
+        if (best >= 0)
+        {
+            used[static_cast<size_t>(best)] = true;
+            tracks.push_back(previousTracks[static_cast<size_t>(best)]);
+            update(tracks.back(), blob);
+        }
+        else
+        {
+            tracks.push_back(Track{centroid, cv::Point2d(0.0, 0.0), blob.boundingBox, cv::Rect(), cv::Rect()});
+        }
+    }
+}
+
+void ConeTracker::update(Track &track, const Blob &blob)
+{
+    const cv::Point2d centroid = blob.centroid();
+    track.velocity = track.velocity * (1.0 - VELOCITY_GAIN) + (centroid - track.centroid) * VELOCITY_GAIN;
+    track.centroid = centroid;
+    track.box = blob.boundingBox;
+}
+
+bool ConeTracker::clipped(const Blob &blob) const
+{
+    const cv::Point2d centroid = blob.centroid();
+    const cv::Point inside(static_cast<int>(centroid.x), static_cast<int>(centroid.y));
+    const cv::Rect &box = blob.boundingBox;
+    for (const cv::Rect &window : windows)
+    {
+        if (window.contains(inside))
+        {
+            return (box.x == window.x && window.x > 0) ||
+                   (box.y == window.y && window.y > 0) ||
+                   (box.x + box.width == window.x + window.width && window.x + window.width < area.width) ||
+                   (box.y + box.height == window.y + window.height && window.y + window.height < area.height);
+        }
+    }
+    return true;
+}
+
+bool ConeTracker::isCone(const Blob &blob)
+{
+    return blob.contourArea >= AngleCalculator::MIN_CONE_AREA && blob.contourArea <= AngleCalculator::MAX_CONE_AREA;
+}
+
+void ConeTracker::Print(std::ostream &out) const
+{
+    out << "Cone tracker: frames=" << frames << " full searches scheduled=" << scheduledSearches << " after a lost track=" << fallbackSearches;
+    if (frames > 0)
+    {
+        out << " (fallback rate=" << 100.0 * static_cast<double>(fallbackSearches) / static_cast<double>(frames) << "%)";
+    }
+    out << " predictions=" << predictions;
+    if (predictions > 0)
+    {
+        out << " hit rate=" << 100.0 * static_cast<double>(hits) / static_cast<double>(predictions) << "%";
+    }
+    if (pixelsFullSearch > 0)
+    {
+        out << " pixels segmented=" << 100.0 * static_cast<double>(pixelsSegmented) / static_cast<double>(pixelsFullSearch)
+            << "% of a full search per frame (windows " << 100.0 * static_cast<double>(pixelsInWindows) / static_cast<double>(pixelsFullSearch)
+            << "%, full searches " << 100.0 * static_cast<double>(pixelsSegmented - pixelsInWindows) / static_cast<double>(pixelsFullSearch) << "%)";
+    }
+    out << std::endl;
+}
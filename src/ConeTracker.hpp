@@ -0,0 +1,111 @@
+#ifndef CONE_TRACKER_HPP
+#define CONE_TRACKER_HPP
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "BlobExtractor.hpp"
+#include "FramePipeline.hpp"
+
+// Keeps the cones of the steering path as tracks across frames, so that most frames only have
+// to segment the pixels around them. Every track predicts its next position from its last
+// motion (constant velocity), and at steady state the pipeline runs on a small window around
+// each prediction (FramePipeline::ProcessWindows) instead of the whole region.
+//
+// The whole region is searched again (FramePipeline::ProcessStreaming, or ProcessCoarseToFine
+// with a coarse level)
+//  - every fullSearchInterval frames, which is how new cones are picked up,
+//  - when there are no tracks,
+//  - right away in the same frame when a track is lost: no cone in its window, or the cone
+//    touches the edge of the window and may have been cut off (the same for a cone that came
+//    into a window and was cut off).
+// Cones that come into view away from the tracked ones are only found by the next full search.
+//
+// The pixel work is about a fifth of a full search on every frame at the default interval of 10,
+// and not the tenth first aimed for: the full searches alone are 1 / fullSearchInterval of it, and
+// the windows cost about a tenth of a full search on their own, most of it the WINDOW_MARGIN and
+// motion margins around the cones rather than the halos (which windows that far apart cannot
+// share). With a synthetic sequence of 3-5 cones on 640x140 blob rows: 20% at an interval of 10,
+// 14% at 30, about 12% with coarse full searches (1/4).
+// Either way the blobs of the frame are in FramePipeline::blueBlobs() / yellowBlobs() afterwards.
+// Only blobs with a cone's area (AngleCalculator::MIN_CONE_AREA ... MAX_CONE_AREA) are tracked,
+// as the others do not take part in the steering decision.
+class ConeTracker
+{
+public:
+    explicit ConeTracker(int fullSearchInterval);
+
+    void Process(FramePipeline &pipeline, const cv::Rect &region, int blobRows);
+    // Forgets all tracks, e.g. after frames that did not go through Process.
+    void Reset();
+    // Pyramid level of the full searches (FramePipeline::ProcessCoarseToFine); 1 for full resolution.
+    void setCoarseLevel(int level) { coarseLevel = std::max(1, level); }
+
+    // Hit rate of the predictions, how often the full search was scheduled or needed, and how
+    // many pixels were segmented compared to a full search on every frame, in total and in the
+    // windows alone.
+    void Print(std::ostream &out) const;
+    uint64_t framesProcessed() const { return frames; }
+
+private:
+    struct Track
+    {
+        cv::Point2d centroid;
+        cv::Point2d velocity; // Pixels per frame.
+        cv::Rect box;
+        cv::Rect predicted; // Box moved by the velocity.
+        cv::Rect window;    // Search window around predicted, in region coordinates.
+    };
+
+    // Pixels added around the predicted bounding box on every side, on top of the motion.
+    static constexpr int WINDOW_MARGIN = 8;
+    // Weight of the newest displacement in the velocity.
+    static constexpr double VELOCITY_GAIN = 0.5;
+
+    // Blob index per track of a windowed pass, and which blobs were claimed by a track.
+    struct Matching
+    {
+        std::vector<int> matches;
+        std::vector<bool> used;
+    };
+
+    void predict(std::vector<Track> &tracks);
+    // Matches the blobs of a windowed pass to the tracks without changing them. Returns false if
+    // a track was lost.
+    bool match(const std::vector<Track> &tracks, const std::vector<Blob> &blobs, Matching &matching);
+    // Moves the matched tracks to their blobs, drops the others and starts tracks for the
+    // unclaimed cones. Only called once both colours matched, so a lost track of one colour
+    // leaves the tracks of the other one for restart as they were predicted.
+    void follow(std::vector<Track> &tracks, const std::vector<Blob> &blobs, const Matching &matching);
+    // Rebuilds the tracks from the blobs of a full search, keeping the motion of the tracks found again.
+    void restart(std::vector<Track> &tracks, const std::vector<Blob> &blobs);
+    // Whether blob touches an edge of the search window it was found in that is not an edge of the region.
+    bool clipped(const Blob &blob) const;
+    static bool isCone(const Blob &blob);
+    static void update(Track &track, const Blob &blob);
+
+    int interval;
+    int coarseLevel{1};
+    int framesSinceFullSearch{0};
+    cv::Size area; // Width of the region and the number of blob rows.
+    std::vector<Track> blueTracks;
+    std::vector<Track> yellowTracks;
+    std::vector<Track> previousTracks;
+    std::vector<cv::Rect> windows;
+    std::vector<bool> used; // Tracks found again in restart.
+    Matching blueMatching;
+    Matching yellowMatching;
+
+    uint64_t frames{0};
+    uint64_t scheduledSearches{0};
+    uint64_t fallbackSearches{0};
+    uint64_t predictions{0};
+    uint64_t hits{0};
+    uint64_t pixelsSegmented{0};
+    uint64_t pixelsInWindows{0};
+    uint64_t pixelsFullSearch{0};
+};
+
+#endif // CONE_TRACKER_HPP
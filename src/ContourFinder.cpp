@@ -2,7 +2,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include "ContourFinder.hpp"
 
-ContourFinder::ContourFinder(){};
+ContourFinder::ContourFinder() : significanceProbe() {};
 
 cv::Mat ContourFinder::FindContours(const cv::Mat &imageInput,const cv::Mat &originalInput, int &minContourArea, int &maxContourArea){
     // Find contours and save them in contours.
@@ -29,16 +29,12 @@ cv::Mat ContourFinder::FindContours(const cv::Mat &imageInput,const cv::Mat &ori
 }
 
 int ContourFinder::isEmptyOfSignificantContours(const cv::Mat &imageInput) {
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(imageInput, contours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
-
     int minimumArea = 100;
 
-    for (const auto& contour : contours) {
-        double area = cv::contourArea(contour);
-        if (area > minimumArea) {
-            return 1; // Found a contour that is larger than the minimum area
-        }
+    // Only a yes/no answer is needed, so stop at the first blob that is large enough instead of
+    // extracting all of them.
+    if (significanceProbe.HasBlobLargerThan(imageInput, minimumArea)) {
+        return 1; // Found a contour that is larger than the minimum area
     }
     return -1; // No contours found that are larger than the minimum area
 }
@@ -4,6 +4,7 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/core.hpp>
+#include "SignificanceProbe.hpp"
 
 
 
@@ -12,6 +13,10 @@ class ContourFinder{
     ContourFinder();
     cv::Mat FindContours(const cv::Mat &imageInput, const cv::Mat &originalImage, int &minContourArea, int &maxContourArea);
     int isEmptyOfSignificantContours(const cv::Mat &imageInput);
+    const SignificanceProbe &probe() const { return significanceProbe; }
+
+    private:
+    SignificanceProbe significanceProbe;
 };
 
 #endif
@@ -0,0 +1,75 @@
+#include <opencv2/highgui/highgui.hpp>
+#include "DebugUi.hpp"
+
+DebugUi::DebugUi(ParameterStore &parameterStore, VisualizationSink *sink)
+    : store(parameterStore),
+      visualizationSink(sink),
+      worker()
+{
+}
+
+DebugUi::~DebugUi()
+{
+    Stop();
+}
+
+void DebugUi::Start()
+{
+    if (!running.exchange(true))
+    {
+        worker = std::thread(&DebugUi::run, this);
+    }
+}
+
+void DebugUi::Stop()
+{
+    running.store(false);
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+void DebugUi::run()
+{
+    store.Load(positions);
+    HsvThresholds published = positions;
+    createTrackbars();
+
+    while (running.load())
+    {
+        if (visualizationSink != nullptr)
+        {
+            visualizationSink->Show();
+        }
+        // Runs the trackbar callbacks, which update positions.
+        cv::waitKey(UI_PERIOD_MS);
+        if (positions != published)
+        {
+            store.Publish(positions);
+            published = positions;
+        }
+    }
+    cv::destroyAllWindows();
+}
+
+void DebugUi::createTrackbars()
+{
+    // Trackbars for manually adjusting HSV during runtime. Makes it easier to experiment with filters and finding
+    // the correct HSV values.
+    cv::namedWindow("BlueTrackingControl", cv::WINDOW_AUTOSIZE);
+    cv::createTrackbar("LowH", "BlueTrackingControl", &positions.blue.lowH, 179); // Hue (0 - 179)
+    cv::createTrackbar("HighH", "BlueTrackingControl", &positions.blue.highH, 179);
+    cv::createTrackbar("LowS", "BlueTrackingControl", &positions.blue.lowS, 255); // Saturation (0 - 255)
+    cv::createTrackbar("HighS", "BlueTrackingControl", &positions.blue.highS, 255);
+    cv::createTrackbar("LowV", "BlueTrackingControl", &positions.blue.lowV, 255); // Value (0 - 255)
+    cv::createTrackbar("HighV", "BlueTrackingControl", &positions.blue.highV, 255);
+
+    cv::namedWindow("YellowTrackingControl", cv::WINDOW_AUTOSIZE);
+    cv::createTrackbar("LowH", "YellowTrackingControl", &positions.yellow.lowH, 179); // Hue (0 - 179)
+    cv::createTrackbar("HighH", "YellowTrackingControl", &positions.yellow.highH, 179);
+    cv::createTrackbar("LowS", "YellowTrackingControl", &positions.yellow.lowS, 255); // Saturation (0 - 255)
+    cv::createTrackbar("HighS", "YellowTrackingControl", &positions.yellow.highS, 255);
+    cv::createTrackbar("LowV", "YellowTrackingControl", &positions.yellow.lowV, 255); // Value (0 - 255)
+    cv::createTrackbar("HighV", "YellowTrackingControl", &positions.yellow.highV, 255);
+}
@@ -0,0 +1,40 @@
+#ifndef DEBUG_UI_HPP
+#define DEBUG_UI_HPP
+
+#include <atomic>
+#include <thread>
+#include "HsvColorSeparator.hpp"
+#include "ParameterStore.hpp"
+#include "VisualizationSink.hpp"
+
+// Thread that owns every HighGUI window of the --verbose mode: the HSV trackbars and the debug
+// view of the VisualizationSink. The trackbars are created once and write into values only
+// this thread touches; changes are published to the ParameterStore, which the processing
+// loop reads once per frame. The processing loop makes no window calls at all.
+class DebugUi
+{
+public:
+    // sink may be null.
+    DebugUi(ParameterStore &parameterStore, VisualizationSink *sink);
+    ~DebugUi();
+    DebugUi(const DebugUi &) = delete;
+    DebugUi &operator=(const DebugUi &) = delete;
+
+    void Start();
+    void Stop();
+
+private:
+    // Event loop period; also bounds how late a trackbar change reaches the store.
+    static constexpr int UI_PERIOD_MS = 15;
+
+    void run();
+    void createTrackbars();
+
+    ParameterStore &store;
+    VisualizationSink *visualizationSink;
+    HsvThresholds positions{}; // Bound to the trackbars.
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+#endif // DEBUG_UI_HPP
@@ -6,33 +6,61 @@
 #include "DirectionCalculator.hpp"
 #include "CommonDefs.hpp"
 
-DirectionCalculator::DirectionCalculator() {}
+DirectionCalculator::DirectionCalculator()
+    : denoised(),
+      blurred(),
+      eroded()
+{
+}
 
-int DirectionCalculator::CalculateDirection(cv::Mat &inputImage, int &direction, bool VERBOSE)
+int DirectionCalculator::CalculateDirection(cv::Mat &inputImage, int &direction)
 {
 
     cv::Mat hsvConvertedImg;
 
     cv::cvtColor(inputImage, hsvConvertedImg, CV_BGR2HSV);
 
-    int width = inputImage.cols / 2;
-    int adjustedHeight = static_cast<int>(inputImage.rows * 0.8);
+    cv::Rect leftHalf;
+    cv::Rect rightHalf;
+    halves(inputImage.size(), leftHalf, rightHalf);
+
+    cv::Mat leftYellowMask = colorSeparator.detectYellowColor(hsvConvertedImg(leftHalf));
+    cv::Mat rightYellowMask = colorSeparator.detectYellowColor(hsvConvertedImg(rightHalf));
+    return directionFromMasks(leftYellowMask, rightYellowMask, direction);
+}
+
+int DirectionCalculator::CalculateDirection(FramePipeline &framePipeline, const cv::Size &frameSize, int &direction)
+{
+    cv::Rect leftHalf;
+    cv::Rect rightHalf;
+    halves(frameSize, leftHalf, rightHalf);
+
+    // Both halves cover the same rows, so the first call segments them for both (and for the
+    // steering path where it overlaps the bottom half).
+    const cv::Mat leftYellowMask = framePipeline.segmentedYellow(leftHalf);
+    const cv::Mat rightYellowMask = framePipeline.segmentedYellow(rightHalf);
+    return directionFromMasks(leftYellowMask, rightYellowMask, direction);
+}
+
+void DirectionCalculator::halves(const cv::Size &frameSize, cv::Rect &leftHalf, cv::Rect &rightHalf) const
+{
+    int width = frameSize.width / 2;
+    int adjustedHeight = static_cast<int>(frameSize.height * 0.8);
 
     // Define the rectangles for the left and right halves
-    cv::Rect leftHalf(0, 0, width, adjustedHeight);
-    cv::Rect rightHalf(inputImage.cols / 2, 0, width, adjustedHeight);
+    leftHalf = cv::Rect(0, 0, width, adjustedHeight);
+    rightHalf = cv::Rect(frameSize.width / 2, 0, width, adjustedHeight);
+}
 
+int DirectionCalculator::directionFromMasks(const cv::Mat &leftYellowMask, const cv::Mat &rightYellowMask, int &direction)
+{
     // Process left half
-    cv::Mat leftImage = hsvConvertedImg(leftHalf);
-    cv::Mat leftYellowMask = colorSeparator.detectYellowColor(leftImage, VERBOSE);
-    leftYellowMask = noiseRemover.RemoveNoise(leftYellowMask);
-    int leftYellow = contourFinder.isEmptyOfSignificantContours(leftYellowMask);
+    noiseRemover.RemoveNoise(leftYellowMask, denoised, blurred, eroded);
+    int leftYellow = contourFinder.isEmptyOfSignificantContours(denoised);
 
     // Process right half
-    cv::Mat rightImage = hsvConvertedImg(rightHalf);
-    cv::Mat rightYellowMask = colorSeparator.detectYellowColor(rightImage, VERBOSE);
-    rightYellowMask = noiseRemover.RemoveNoise(rightYellowMask);
-    int rightYellow = contourFinder.isEmptyOfSignificantContours(rightYellowMask);
+    noiseRemover.RemoveNoise(rightYellowMask, denoised, blurred, eroded);
+    int rightYellow = contourFinder.isEmptyOfSignificantContours(denoised);
 
     if (leftYellow == 1 && rightYellow == -1)
     {
@@ -48,4 +76,4 @@ int DirectionCalculator::CalculateDirection(cv::Mat &inputImage, int &direction,
     {
         return direction; // No direction or both sides have yellow
     }
-}
\ No newline at end of file
+}
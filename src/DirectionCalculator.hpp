@@ -4,12 +4,25 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
+#include "FramePipeline.hpp"
 
 class DirectionCalculator
 {
 public:
     DirectionCalculator();
-    int CalculateDirection(cv::Mat &inputImage, int &direction, bool VERBOSE);
+    int CalculateDirection(cv::Mat &inputImage, int &direction);
+    // Same, but takes the yellow masks from the segmentation cache of the current frame instead of
+    // converting and thresholding the image again. frameSize is the size of the full frame.
+    int CalculateDirection(FramePipeline &framePipeline, const cv::Size &frameSize, int &direction);
+
+private:
+    void halves(const cv::Size &frameSize, cv::Rect &leftHalf, cv::Rect &rightHalf) const;
+    int directionFromMasks(const cv::Mat &leftYellowMask, const cv::Mat &rightYellowMask, int &direction);
+
+    // Reused noise removal buffers.
+    cv::Mat denoised;
+    cv::Mat blurred;
+    cv::Mat eroded;
 };
 
-#endif // DIRECTION_CALCULATOR_HPP
\ No newline at end of file
+#endif // DIRECTION_CALCULATOR_HPP
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cmath>
+#include "AngleCalculator.hpp"
+#include "DirectionEstimator.hpp"
+
+constexpr double DirectionEstimator::REFERENCE_WEIGHT;
+
+DirectionEstimator::DirectionEstimator()
+{
+}
+
+int DirectionEstimator::Update(const std::vector<Blob> &yellow, const std::vector<Blob> &blue, int regionWidth)
+{
+    frames++;
+    double sum = 0.0;
+    double weight = 0.0;
+    // Yellow on the left means counter-clockwise, blue on the left clockwise.
+    vote(yellow, regionWidth, 1, sum, weight);
+    vote(blue, regionWidth, -1, sum, weight);
+    // Frames with too little weight (no cones, or only small ones near the centre line) only let
+    // the older evidence fade; the others vote with their confidence, up to one full vote.
+    evidence = DECAY * evidence;
+    if (weight >= MIN_FRAME_WEIGHT)
+    {
+        evidence += sum / std::max(weight, REFERENCE_WEIGHT);
+    }
+    else
+    {
+        framesWithoutCones++;
+    }
+
+    int next = current;
+    if (evidence >= SWITCH_SCORE)
+    {
+        next = 1;
+    }
+    else if (evidence <= -SWITCH_SCORE)
+    {
+        next = -1;
+    }
+    if (next != current)
+    {
+        current = next;
+        lastChange = frames;
+        changes++;
+    }
+    return current;
+}
+
+void DirectionEstimator::vote(const std::vector<Blob> &blobs, int regionWidth, int leftSign, double &sum, double &weight) const
+{
+    const double halfWidth = 0.5 * regionWidth;
+    for (const Blob &blob : blobs)
+    {
+        if (blob.contourArea < AngleCalculator::MIN_CONE_AREA || blob.contourArea > AngleCalculator::MAX_CONE_AREA)
+        {
+            continue;
+        }
+        const double offset = (blob.centroid().x - halfWidth) / halfWidth;
+        const double lateral = std::min(1.0, std::max(0.0, (std::abs(offset) - CENTER_DEAD_ZONE) / (1.0 - CENTER_DEAD_ZONE)));
+        const double confidence = lateral * blob.contourArea / AngleCalculator::MAX_CONE_AREA;
+        sum += (offset < 0.0 ? leftSign : -leftSign) * confidence;
+        weight += confidence;
+    }
+}
+
+void DirectionEstimator::Print(std::ostream &out) const
+{
+    const char *name = (current == -1) ? "clockwise" : (current == 1) ? "counter-clockwise" : "unknown";
+    out << "Direction estimator: " << name << " after " << frames << " frames, converged after " << lastChange
+        << " frames, changes=" << changes << " score=" << evidence << " frames without a vote=" << framesWithoutCones << std::endl;
+}
@@ -0,0 +1,64 @@
+#ifndef DIRECTION_ESTIMATOR_HPP
+#define DIRECTION_ESTIMATOR_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "BlobExtractor.hpp"
+
+// Infers the track direction from the cones the steering path detects on every frame, instead
+// of a separate pass over the upper part of the frame (DirectionCalculator). Clockwise tracks
+// have blue cones on the left and yellow cones on the right; every cone votes for the direction
+// its colour and side stand for, with a confidence from
+//  - how far it is from the centre line (a cone in the middle says little about the side), and
+//  - its size relative to the largest cone area (small blobs are more often noise).
+// The votes of a frame are divided by their total confidence, but by at least REFERENCE_WEIGHT,
+// and added to a leaky score: a frame with one typical, well-placed cone or more casts a full
+// vote of up to +-1, a frame with only small cones near the centre line a fraction of one, so a
+// single frame with a misdetected cone cannot flip the direction. Frames below MIN_FRAME_WEIGHT
+// do not vote at all. The direction only changes once the score passes SWITCH_SCORE in the other
+// direction (hysteresis); until then the previous one is kept.
+class DirectionEstimator
+{
+public:
+    DirectionEstimator();
+
+    // Same convention as the steering loop: -1 clockwise, 1 counter-clockwise, 0 not known yet.
+    // The blobs are the ones of the steering region (AngleCalculator); regionWidth is its width.
+    int Update(const std::vector<Blob> &yellow, const std::vector<Blob> &blue, int regionWidth);
+    int direction() const { return current; }
+    double score() const { return evidence; }
+
+    // Frames until the direction was settled, i.e. the frame of the last change.
+    uint64_t convergenceFrames() const { return lastChange; }
+    void Print(std::ostream &out) const;
+
+private:
+    // Weight of the older frames in the score.
+    static constexpr double DECAY = 0.9;
+    // Score needed to change the direction. With DECAY = 0.9 the score of a steady, unanimous
+    // full vote approaches 10, so this takes 5 frames from 0 and 12 from the other side; frames
+    // of half the reference weight take 16 from 0, and frames below 0.4 of it never switch alone.
+    static constexpr double SWITCH_SCORE = 4.0;
+    // Cones within this fraction of the half width of the centre line get no weight.
+    static constexpr double CENTER_DEAD_ZONE = 0.1;
+    // Confidence of a frame that casts a full vote: one typical cone (400 px) a little more than
+    // half way from the centre line to the edge (0.4 x 0.5).
+    static constexpr double REFERENCE_WEIGHT = 0.2;
+    // Total weight a frame needs to vote at all: just under one cone of MIN_CONE_AREA a quarter of
+    // the way from the centre line to the edge (0.13 x 0.167 = 0.022).
+    static constexpr double MIN_FRAME_WEIGHT = 0.02;
+
+    // Votes of blobs: sign is the direction for a cone of this colour on the left.
+    void vote(const std::vector<Blob> &blobs, int regionWidth, int leftSign, double &sum, double &weight) const;
+
+    int current{0};
+    double evidence{0.0};
+    uint64_t frames{0};
+    uint64_t lastChange{0};
+    uint64_t changes{0};
+    uint64_t framesWithoutCones{0}; // Frames below MIN_FRAME_WEIGHT.
+};
+
+#endif // DIRECTION_ESTIMATOR_HPP
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <iostream>
+#include "FrameAcquisition.hpp"
+
+FrameAcquisition::FrameAcquisition(cluon::SharedMemory &sm, FrameIngestor &frameIngestor, FrameRing &frameRing,
+                                   TimingStats &lockHoldStats, bool verbose)
+    : sharedMemory(sm),
+      ingestor(frameIngestor),
+      ring(frameRing),
+      lockStats(lockHoldStats),
+      VERBOSE(verbose),
+      worker()
+{
+}
+
+FrameAcquisition::~FrameAcquisition()
+{
+    Stop();
+}
+
+void FrameAcquisition::Start()
+{
+    stopped.store(false);
+    running.store(true);
+    worker = std::thread(&FrameAcquisition::run, this);
+}
+
+void FrameAcquisition::Stop()
+{
+    running.store(false);
+    if (worker.joinable())
+    {
+        // Wake the thread up in case it is sitting in wait(). A single notification is lost if it
+        // comes after the thread checked running but before it entered wait(), and there is no
+        // timed wait on the shared memory, so keep notifying until the thread is out of run().
+        while (!stopped.load())
+        {
+            sharedMemory.notifyAll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        worker.join();
+    }
+}
+
+void FrameAcquisition::run()
+{
+    while (running.load())
+    {
+        sharedMemory.wait();
+        if (!running.load())
+        {
+            break;
+        }
+
+        Frame &frame = ring.writeSlot();
+        const bool full = fullFrameRequested.load(std::memory_order_relaxed);
+
+        sharedMemory.lock();
+        const auto lockAcquired = std::chrono::steady_clock::now();
+        ingestor.Ingest(sharedMemory.data(), full, frame.pixels);
+        std::pair<bool, cluon::data::TimeStamp> ts = sharedMemory.getTimeStamp();
+        sharedMemory.unlock();
+        lockStats.Add(std::chrono::steady_clock::now() - lockAcquired);
+
+        frame.sequence = ++sequence;
+        frame.sampleTimePoint = cluon::time::toMicroseconds(ts.second);
+        frame.fullFrame = full;
+        ring.Publish();
+
+        if (VERBOSE && sequence % 100 == 0)
+        {
+            lockStats.Print(std::clog);
+            std::clog << "Frames captured: " << ring.published() << ", dropped: " << ring.dropped() << std::endl;
+        }
+    }
+    stopped.store(true);
+}
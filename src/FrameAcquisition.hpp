@@ -0,0 +1,45 @@
+#ifndef FRAME_ACQUISITION_HPP
+#define FRAME_ACQUISITION_HPP
+
+#include "cluon-complete.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "FrameIngestor.hpp"
+#include "FrameRing.hpp"
+#include "TimingStats.hpp"
+
+// Waits for new frames in the shared memory on a thread of its own and publishes them into
+// a FrameRing, so a slow frame in the processing loop never delays the next wait().
+class FrameAcquisition
+{
+public:
+    FrameAcquisition(cluon::SharedMemory &sharedMemory, FrameIngestor &frameIngestor, FrameRing &frameRing,
+                     TimingStats &lockHoldStats, bool verbose);
+    ~FrameAcquisition();
+    FrameAcquisition(const FrameAcquisition &) = delete;
+    FrameAcquisition &operator=(const FrameAcquisition &) = delete;
+
+    void Start();
+    void Stop();
+
+    // Asks the producer to copy the whole frame (instead of the bottom half) from now on.
+    void RequestFullFrame(bool full) { fullFrameRequested.store(full, std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    cluon::SharedMemory &sharedMemory;
+    FrameIngestor &ingestor;
+    FrameRing &ring;
+    TimingStats &lockStats;
+    const bool VERBOSE;
+    std::atomic<bool> running{false};
+    // Set by the thread when it leaves run(); Stop() keeps waking it up until then.
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> fullFrameRequested{true};
+    uint64_t sequence{0};
+    std::thread worker;
+};
+
+#endif // FRAME_ACQUISITION_HPP
@@ -0,0 +1,101 @@
+#include <opencv2/core.hpp>
+#include <cstring>
+#include "FrameIngestor.hpp"
+
+FrameIngestor::FrameIngestor(Mode mode, uint32_t frameWidth, uint32_t frameHeight)
+    : ingestMode(mode),
+      width(frameWidth),
+      height(frameHeight),
+      rowBytes(static_cast<size_t>(frameWidth) * 4),
+      // Same region as the steering path crops: the bottom 50% of the image.
+      roi(0, static_cast<int>(frameHeight / 2), static_cast<int>(frameWidth), static_cast<int>(frameHeight / 2)),
+      frame()
+{
+    if (ingestMode == Mode::RoiCopy)
+    {
+        // Allocated once; rows that were not copied keep stale data and must not be read.
+        frame.create(static_cast<int>(height), static_cast<int>(width), CV_8UC4);
+    }
+}
+
+void FrameIngestor::Ingest(char *sharedData, bool needFullFrame)
+{
+    Ingest(sharedData, needFullFrame, frame);
+}
+
+void FrameIngestor::Ingest(char *sharedData, bool needFullFrame, cv::Mat &destination)
+{
+    const size_t fullBytes = rowBytes * height;
+    size_t copiedBytes = fullBytes;
+
+    switch (ingestMode)
+    {
+    case Mode::Clone:
+    {
+        cv::Mat wrapped(static_cast<int>(height), static_cast<int>(width), CV_8UC4, sharedData);
+        destination = wrapped.clone();
+        break;
+    }
+    case Mode::RoiCopy:
+        if (needFullFrame)
+        {
+            std::memcpy(destination.data, sharedData, fullBytes);
+        }
+        else
+        {
+            const size_t offset = rowBytes * static_cast<size_t>(roi.y);
+            copiedBytes = rowBytes * static_cast<size_t>(roi.height);
+            std::memcpy(destination.data + offset, sharedData + offset, copiedBytes);
+        }
+        break;
+    case Mode::ZeroCopy:
+        // Only a header is created; the pixels stay in the shared memory area.
+        destination = cv::Mat(static_cast<int>(height), static_cast<int>(width), CV_8UC4, sharedData);
+        copiedBytes = 0;
+        break;
+    }
+
+    lastSaved = fullBytes - copiedBytes;
+    totalBytesSaved += lastSaved;
+    frames++;
+}
+
+double FrameIngestor::averageBytesSaved() const
+{
+    return frames > 0 ? static_cast<double>(totalBytesSaved) / static_cast<double>(frames) : 0.0;
+}
+
+bool FrameIngestor::parseMode(const std::string &name, Mode &mode)
+{
+    if (name == "clone")
+    {
+        mode = Mode::Clone;
+    }
+    else if (name == "roi")
+    {
+        mode = Mode::RoiCopy;
+    }
+    else if (name == "zerocopy")
+    {
+        mode = Mode::ZeroCopy;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char *FrameIngestor::modeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::Clone:
+        return "clone";
+    case Mode::RoiCopy:
+        return "roi";
+    case Mode::ZeroCopy:
+        return "zerocopy";
+    }
+    return "unknown";
+}
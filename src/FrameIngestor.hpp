@@ -0,0 +1,55 @@
+#ifndef FRAME_INGESTOR_HPP
+#define FRAME_INGESTOR_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <string>
+
+// Moves a frame out of the shared memory area into something the pipeline can read.
+// Only the bottom half of the frame is used for steering, so there is no need to copy
+// the whole WIDTH x HEIGHT x 4 buffer on every frame.
+class FrameIngestor
+{
+public:
+    enum class Mode
+    {
+        Clone,   // Deep copy of the full frame (original behaviour).
+        RoiCopy, // Copy only the rows the pipeline reads into a preallocated buffer.
+        ZeroCopy // Wrap the shared memory directly; only valid while the lock is held.
+    };
+
+    FrameIngestor(Mode mode, uint32_t width, uint32_t height);
+
+    // Must be called while the shared memory is locked. When needFullFrame is set the
+    // whole frame is made available, otherwise only the bottom half is guaranteed.
+    void Ingest(char *sharedData, bool needFullFrame);
+    // Same as above, but writes into a caller-owned buffer. For RoiCopy the destination
+    // must already be allocated as HEIGHT x WIDTH CV_8UC4.
+    void Ingest(char *sharedData, bool needFullFrame, cv::Mat &destination);
+
+    const cv::Mat &fullFrame() const { return frame; }
+    cv::Mat bottomHalf() const { return frame(roi); }
+    const cv::Rect &bottomHalfRect() const { return roi; }
+
+    Mode mode() const { return ingestMode; }
+    uint64_t framesIngested() const { return frames; }
+    uint64_t bytesSaved() const { return totalBytesSaved; }
+    uint64_t lastBytesSaved() const { return lastSaved; }
+    double averageBytesSaved() const;
+
+    static bool parseMode(const std::string &name, Mode &mode);
+    static const char *modeName(Mode mode);
+
+private:
+    Mode ingestMode;
+    uint32_t width;
+    uint32_t height;
+    size_t rowBytes;
+    cv::Rect roi;
+    cv::Mat frame;
+    uint64_t frames{0};
+    uint64_t totalBytesSaved{0};
+    uint64_t lastSaved{0};
+};
+
+#endif // FRAME_INGESTOR_HPP
@@ -0,0 +1,621 @@
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include "AngleCalculator.hpp"
+#include "CommonDefs.hpp"
+#include "FramePipeline.hpp"
+#include "SegmentationKernels.hpp"
+
+FramePipeline::FramePipeline()
+    : colorLut(),
+      colorTiming("Colour separation"),
+      referenceTiming("Colour separation (cvtColor + inRange reference)"),
+      streamingTiming("Row-streaming pipeline"),
+      coarseTiming("Coarse pass of the coarse-to-fine pipeline"),
+      frameInput(),
+      scaledInput(),
+      hsvImg(),
+      blueThresh(),
+      yellowThresh(),
+      scaledHsv(),
+      scaledBlueThresh(),
+      scaledYellowThresh(),
+      blurred(),
+      eroded(),
+      blueDenoised(),
+      yellowDenoised(),
+      classThresh(),
+      classDenoised(),
+      blueRescaled(),
+      yellowRescaled(),
+      blueOutput(),
+      yellowOutput(),
+      threadPool(),
+      stripes(),
+      windows(),
+      stripeBlobs(),
+      stripeMerger(),
+      streamedBlue(),
+      streamedYellow(),
+      coarseInput(),
+      coarseBlue(),
+      coarseYellow(),
+      candidateWindows(),
+      referenceHsv(),
+      referenceBlue(),
+      referenceYellow(),
+      referenceBlurred(),
+      referenceEroded(),
+      referenceDenoised(),
+      bufferData(),
+      lastSize()
+{
+}
+
+void FramePipeline::BeginFrame(const cv::Mat &frame)
+{
+    frameInput = frame;
+    coveredBegin = 0;
+    coveredEnd = 0;
+    // Thresholds only change between frames: one version check, and a copy if the UI published.
+    if (parameterStore.version() != thresholdsVersion)
+    {
+        HsvThresholds thresholds{};
+        thresholdsVersion = parameterStore.Load(thresholds);
+        colorSeparator.setThresholds(thresholds);
+    }
+    // No-ops unless the frame size changed.
+    blueThresh.create(frame.rows, frame.cols, CV_8UC1);
+    yellowThresh.create(frame.rows, frame.cols, CV_8UC1);
+    if (colorStage == ColorMode::Simd)
+    {
+        hsvImg.create(frame.rows, frame.cols, CV_8UC3);
+    }
+}
+
+cv::Mat FramePipeline::segmentedYellow(const cv::Rect &region)
+{
+    segmentRows(region.y, region.y + region.height);
+    return yellowThresh(region);
+}
+
+cv::Mat FramePipeline::segmentedBlue(const cv::Rect &region)
+{
+    segmentRows(region.y, region.y + region.height);
+    return blueThresh(region);
+}
+
+void FramePipeline::segmentRows(int rowBegin, int rowEnd)
+{
+    if (coveredEnd <= coveredBegin)
+    {
+        coveredBegin = rowBegin;
+        coveredEnd = rowBegin;
+    }
+    // Keep the covered rows contiguous; a gap between two requests is filled in as well.
+    const int newBegin = std::min(rowBegin, coveredBegin);
+    const int newEnd = std::max(rowEnd, coveredEnd);
+    if (newBegin == coveredBegin && newEnd == coveredEnd)
+    {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool useLut = prepareColorStage();
+    const int ranges[2][2] = {{newBegin, coveredBegin}, {coveredEnd, newEnd}};
+    for (const auto &range : ranges)
+    {
+        if (range[1] > range[0])
+        {
+            cv::Mat blueRows = blueThresh.rowRange(range[0], range[1]);
+            cv::Mat yellowRows = yellowThresh.rowRange(range[0], range[1]);
+            cv::Mat hsvRows = (colorStage == ColorMode::Simd) ? hsvImg.rowRange(range[0], range[1]) : cv::Mat();
+            const cv::Mat input = frameInput.rowRange(range[0], range[1]);
+            separateColors(input, blueRows, yellowRows, hsvRows, useLut);
+            if (verify)
+            {
+                verifyColorSeparation(input, blueRows, yellowRows);
+            }
+        }
+    }
+    colorTiming.Add(std::chrono::steady_clock::now() - start);
+    coveredBegin = newBegin;
+    coveredEnd = newEnd;
+}
+
+void FramePipeline::Process(const cv::Rect &region, int scale)
+{
+    // Colour separation converts to HSV and thresholds blue and yellow in one pass over the image.
+    // Use gaussian blur to smooth out image, and morphological operations
+    // Erode makes objects smaller but fills in the holes. Dilate does the opposite, so if you combine them
+    // it will make a nice end result
+    cv::Mat yellowInput;
+    cv::Mat blueInput;
+    if (scale > 1)
+    {
+        const double factor = 1.0 / scale;
+        cv::resize(frameInput(region), scaledInput, cv::Size(), factor, factor, cv::INTER_NEAREST);
+        const auto start = std::chrono::steady_clock::now();
+        separateColors(scaledInput, scaledBlueThresh, scaledYellowThresh, scaledHsv, prepareColorStage());
+        colorTiming.Add(std::chrono::steady_clock::now() - start);
+        if (verify)
+        {
+            verifyColorSeparation(scaledInput, scaledBlueThresh, scaledYellowThresh);
+        }
+        yellowInput = scaledYellowThresh;
+        blueInput = scaledBlueThresh;
+    }
+    else
+    {
+        yellowInput = segmentedYellow(region);
+        blueInput = blueThresh(region);
+    }
+
+    if (noiseRemover.engine() == NoiseRemover::Engine::Classes)
+    {
+        // One traversal for both colours.
+        mergeClasses(blueInput, yellowInput, classThresh);
+        noiseRemover.RemoveNoiseClasses(classThresh, classDenoised);
+        splitClasses(classDenoised, blueDenoised, yellowDenoised);
+    }
+    else
+    {
+        noiseRemover.RemoveNoise(yellowInput, yellowDenoised, blurred, eroded);
+        noiseRemover.RemoveNoise(blueInput, blueDenoised, blurred, eroded);
+    }
+    if (verify)
+    {
+        verifyNoiseRemoval(yellowInput, yellowDenoised);
+        verifyNoiseRemoval(blueInput, blueDenoised);
+    }
+
+    if (scale > 1)
+    {
+        cv::resize(yellowDenoised, yellowRescaled, region.size(), 0, 0, cv::INTER_NEAREST);
+        cv::resize(blueDenoised, blueRescaled, region.size(), 0, 0, cv::INTER_NEAREST);
+        yellowOutput = yellowRescaled;
+        blueOutput = blueRescaled;
+    }
+    else
+    {
+        yellowOutput = yellowDenoised;
+        blueOutput = blueDenoised;
+    }
+
+    trackBuffers(region.size(), scale);
+}
+
+void FramePipeline::mergeClasses(const cv::Mat &blue, const cv::Mat &yellow, cv::Mat &classes)
+{
+    classes.create(blue.rows, blue.cols, CV_8UC1);
+    for (int y = 0; y < blue.rows; y++)
+    {
+        const uchar *blueRow = blue.ptr<uchar>(y);
+        const uchar *yellowRow = yellow.ptr<uchar>(y);
+        uchar *classRow = classes.ptr<uchar>(y);
+        for (int x = 0; x < blue.cols; x++)
+        {
+            classRow[x] = static_cast<uchar>((blueRow[x] & BLUE_CLASS) | (yellowRow[x] & YELLOW_CLASS));
+        }
+    }
+}
+
+void FramePipeline::splitClasses(const cv::Mat &classes, cv::Mat &blue, cv::Mat &yellow)
+{
+    blue.create(classes.rows, classes.cols, CV_8UC1);
+    yellow.create(classes.rows, classes.cols, CV_8UC1);
+    for (int y = 0; y < classes.rows; y++)
+    {
+        const uchar *classRow = classes.ptr<uchar>(y);
+        uchar *blueRow = blue.ptr<uchar>(y);
+        uchar *yellowRow = yellow.ptr<uchar>(y);
+        for (int x = 0; x < classes.cols; x++)
+        {
+            blueRow[x] = (classRow[x] & BLUE_CLASS) ? 255 : 0;
+            yellowRow[x] = (classRow[x] & YELLOW_CLASS) ? 255 : 0;
+        }
+    }
+}
+
+FramePipeline::Stripe::Stripe()
+    : filter(),
+      blueBlobs(),
+      yellowBlobs(),
+      hsvRow(),
+      blueRow(),
+      yellowRow(),
+      classRow(),
+      windowRow()
+{
+}
+
+void FramePipeline::setThreads(int threads)
+{
+    if (threads > 1)
+    {
+        threadPool.reset(new ThreadPool(threads));
+    }
+    else
+    {
+        threadPool.reset();
+    }
+}
+
+void FramePipeline::ProcessStreaming(const cv::Rect &region, int blobRows)
+{
+    const auto start = std::chrono::steady_clock::now();
+    streamStripes(frameInput(region), blobRows, prepareColorStage(), streamedBlue, streamedYellow);
+    streamingTiming.Add(std::chrono::steady_clock::now() - start);
+}
+
+void FramePipeline::streamStripes(const cv::Mat &pixels, int blobRows, bool useLut, std::vector<Blob> &blue, std::vector<Blob> &yellow)
+{
+    blobRows = std::max(0, std::min(blobRows, pixels.rows));
+    const int stripeCount = std::max(1, std::min(threads(), blobRows));
+    reserveStripes(stripeCount);
+    windows.clear();
+    for (int k = 0; k < stripeCount; k++)
+    {
+        const int rowBegin = blobRows * k / stripeCount;
+        windows.push_back(cv::Rect(0, rowBegin, pixels.cols, blobRows * (k + 1) / stripeCount - rowBegin));
+    }
+    streamWindows(pixels, useLut);
+
+    stripeBlobs.clear();
+    for (int k = 0; k < stripeCount; k++)
+    {
+        stripeBlobs.push_back(&stripes[static_cast<size_t>(k)]->blueBlobs);
+    }
+    stripeMerger.Merge(stripeBlobs, blue);
+    stripeBlobs.clear();
+    for (int k = 0; k < stripeCount; k++)
+    {
+        stripeBlobs.push_back(&stripes[static_cast<size_t>(k)]->yellowBlobs);
+    }
+    stripeMerger.Merge(stripeBlobs, yellow);
+}
+
+void FramePipeline::ProcessCoarseToFine(const cv::Rect &region, int blobRows, int level)
+{
+    if (level <= 1)
+    {
+        ProcessStreaming(region, blobRows);
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    blobRows = std::max(0, std::min(blobRows, region.height));
+    // Coarse pixel (x, y) stands for the full-resolution pixels [level * x, level * x + level).
+    const cv::Size coarseSize((region.width + level - 1) / level, (region.height + level - 1) / level);
+    cv::resize(frameInput(region), coarseInput, coarseSize, 0, 0, cv::INTER_NEAREST);
+    streamStripes(coarseInput, (blobRows + level - 1) / level, prepareColorStage(), coarseBlue, coarseYellow);
+
+    // Both colours are extracted in every window, so the candidates of both share one list.
+    candidateWindows.clear();
+    const cv::Size bounds(region.width, blobRows);
+    addCandidates(coarseBlue, level, bounds);
+    addCandidates(coarseYellow, level, bounds);
+    mergeWindows(candidateWindows);
+    coarseTiming.Add(std::chrono::steady_clock::now() - start);
+
+    ProcessWindows(region, candidateWindows);
+}
+
+void FramePipeline::addCandidates(const std::vector<Blob> &blobs, int level, const cv::Size &bounds)
+{
+    // Erosion and dilation take off a fixed number of pixels, which is a larger part of a cone at
+    // the coarse level; half the minimum area keeps the cones that are just large enough.
+    const double scale = static_cast<double>(level) * level;
+    const int margin = level + COARSE_MARGIN;
+    for (const Blob &blob : blobs)
+    {
+        const double area = blob.contourArea * scale;
+        if (area < 0.5 * AngleCalculator::MIN_CONE_AREA || area > 4.0 * AngleCalculator::MAX_CONE_AREA)
+        {
+            continue;
+        }
+        const cv::Rect &box = blob.boundingBox;
+        const cv::Rect window = cv::Rect(box.x * level - margin, box.y * level - margin, box.width * level + 2 * margin, box.height * level + 2 * margin) &
+                                cv::Rect(cv::Point(0, 0), bounds);
+        if (window.area() > 0)
+        {
+            candidateWindows.push_back(window);
+        }
+    }
+}
+
+void FramePipeline::mergeWindows(std::vector<cv::Rect> &rects)
+{
+    // Windows that overlap or touch become their bounding box, so no cone is split between two.
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < rects.size() && !merged; i++)
+        {
+            const cv::Rect grown(rects[i].x - 1, rects[i].y - 1, rects[i].width + 2, rects[i].height + 2);
+            for (size_t j = i + 1; j < rects.size() && !merged; j++)
+            {
+                if ((grown & rects[j]).area() > 0)
+                {
+                    rects[i] |= rects[j];
+                    rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(j));
+                    merged = true;
+                }
+            }
+        }
+    }
+}
+
+void FramePipeline::ProcessWindows(const cv::Rect &region, const std::vector<cv::Rect> &searchWindows)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const bool useLut = prepareColorStage();
+
+    windows.clear();
+    for (const cv::Rect &window : searchWindows)
+    {
+        const cv::Rect clipped = window & cv::Rect(0, 0, region.width, region.height);
+        if (clipped.area() > 0)
+        {
+            windows.push_back(clipped);
+        }
+    }
+    reserveStripes(static_cast<int>(windows.size()));
+    streamWindows(frameInput(region), useLut);
+
+    streamedBlue.clear();
+    streamedYellow.clear();
+    for (size_t k = 0; k < windows.size(); k++)
+    {
+        const Stripe &stripe = *stripes[k];
+        streamedBlue.insert(streamedBlue.end(), stripe.blueBlobs.blobs().begin(), stripe.blueBlobs.blobs().end());
+        streamedYellow.insert(streamedYellow.end(), stripe.yellowBlobs.blobs().begin(), stripe.yellowBlobs.blobs().end());
+    }
+    streamingTiming.Add(std::chrono::steady_clock::now() - start);
+}
+
+void FramePipeline::reserveStripes(int count)
+{
+    while (static_cast<int>(stripes.size()) < count)
+    {
+        stripes.emplace_back(new Stripe());
+    }
+}
+
+cv::Rect FramePipeline::inputWindow(const cv::Rect &window, const cv::Size &regionSize)
+{
+    // Denoised pixel (x, y) depends on the input pixels within DELAY rows and columns of it.
+    const int halo = ClassMaskFilter<uint8_t>::DELAY;
+    return cv::Rect(window.x - halo, window.y - halo, window.width + 2 * halo, window.height + 2 * halo) & cv::Rect(cv::Point(0, 0), regionSize);
+}
+
+void FramePipeline::streamWindows(const cv::Mat &pixels, bool useLut)
+{
+    const int count = static_cast<int>(windows.size());
+    auto runWindow = [&](int k)
+    {
+        streamWindow(*stripes[static_cast<size_t>(k)], pixels, windows[static_cast<size_t>(k)], useLut);
+    };
+    if (count > 1 && threadPool && !verify)
+    {
+        threadPool->Run(count, runWindow);
+    }
+    else
+    {
+        for (int k = 0; k < count; k++)
+        {
+            runWindow(k);
+        }
+    }
+    for (const cv::Rect &window : windows)
+    {
+        pixelsStreamed += static_cast<uint64_t>(inputWindow(window, pixels.size()).area());
+    }
+}
+
+void FramePipeline::streamWindow(Stripe &stripe, const cv::Mat &pixels, const cv::Rect &window, bool useLut)
+{
+    // Nothing outside of the halo around the window has to be classified, and the filter's border
+    // handling at the ends of the halo only reaches pixels that are not used. Columns of the halo
+    // are cleared before the blob extraction; rows of it are not pushed at all.
+    const cv::Rect input = inputWindow(window, pixels.size());
+    const int width = input.width;
+    const int keepBegin = window.x - input.x;
+    const int keepEnd = keepBegin + window.width;
+
+    stripe.blueRow.create(1, width, CV_8UC1);
+    stripe.yellowRow.create(1, width, CV_8UC1);
+    stripe.classRow.create(1, width, CV_8UC1);
+    stripe.filter.Begin(width, input.height);
+    stripe.blueBlobs.Begin(width, window.y, input.x);
+    stripe.yellowBlobs.Begin(width, window.y, input.x);
+
+    const cv::Mat inputPixels = pixels(input);
+    auto emit = [&](int y)
+    {
+        if (y >= 0 && input.y + y >= window.y && input.y + y < window.y + window.height)
+        {
+            const uchar *row = stripe.filter.outputRow();
+            if (width != window.width)
+            {
+                stripe.windowRow.assign(static_cast<size_t>(width), 0);
+                std::copy(row + keepBegin, row + keepEnd, stripe.windowRow.begin() + keepBegin);
+                row = stripe.windowRow.data();
+            }
+            stripe.blueBlobs.PushRow(row, BLUE_CLASS);
+            stripe.yellowBlobs.PushRow(row, YELLOW_CLASS);
+        }
+    };
+    for (int y = 0; y < input.height; y++)
+    {
+        const cv::Mat inputRow = inputPixels.row(y);
+        separateColors(inputRow, stripe.blueRow, stripe.yellowRow, stripe.hsvRow, useLut);
+        if (verify)
+        {
+            verifyColorSeparation(inputRow, stripe.blueRow, stripe.yellowRow);
+        }
+        mergeClasses(stripe.blueRow, stripe.yellowRow, stripe.classRow);
+        emit(stripe.filter.PushRow(stripe.classRow.ptr<uchar>(0)));
+    }
+    for (int y = stripe.filter.Flush(); y >= 0; y = stripe.filter.Flush())
+    {
+        emit(y);
+    }
+    stripe.blueBlobs.End();
+    stripe.yellowBlobs.End();
+}
+
+void FramePipeline::setColorMode(ColorMode mode)
+{
+    colorStage = mode;
+    if (colorStage == ColorMode::Lut && !colorLut)
+    {
+        colorLut.reset(new ColorLut());
+        colorLut->Update(colorSeparator.thresholds());
+        colorLut->RebuildStep(256);
+    }
+}
+
+bool FramePipeline::prepareColorStage()
+{
+    if (colorStage != ColorMode::Lut)
+    {
+        return false;
+    }
+    // Thresholds may have been changed through the trackbars; catch up a few slabs per frame.
+    colorLut->Update(colorSeparator.thresholds());
+    return colorLut->ready() || colorLut->RebuildStep(LUT_SLABS_PER_FRAME);
+}
+
+void FramePipeline::separateColors(const cv::Mat &input, cv::Mat &blue, cv::Mat &yellow, cv::Mat &hsv, bool useLut)
+{
+    if (useLut)
+    {
+        colorLut->Classify(input, blue, yellow);
+    }
+    else if (colorStage == ColorMode::Simd)
+    {
+        cv::cvtColor(input, hsv, CV_BGR2HSV);
+        colorSeparator.detectConeColorsHsv(hsv, blue, yellow);
+    }
+    else
+    {
+        colorSeparator.detectConeColors(input, blue, yellow);
+    }
+}
+
+void FramePipeline::trackBuffers(const cv::Size &inputSize, int scale)
+{
+    const uint8_t *current[BUFFER_COUNT] = {scaledInput.data, hsvImg.data, blueThresh.data, yellowThresh.data, scaledHsv.data,
+                                            scaledBlueThresh.data, scaledYellowThresh.data, blurred.data, eroded.data, blueDenoised.data,
+                                            yellowDenoised.data, blueRescaled.data, yellowRescaled.data, classThresh.data, classDenoised.data};
+
+    const bool sameShape = (frames > 0) && (inputSize.width == lastSize.width) && (inputSize.height == lastSize.height) && (scale == lastScale);
+    bool reallocated = false;
+    for (int i = 0; i < BUFFER_COUNT; i++)
+    {
+        reallocated = reallocated || (current[i] != bufferData[i]);
+        bufferData[i] = current[i];
+    }
+    if (sameShape && reallocated)
+    {
+        reallocatedFrames++;
+    }
+
+    lastSize = inputSize;
+    lastScale = scale;
+    frames++;
+}
+
+void FramePipeline::verifyColorSeparation(const cv::Mat &input, const cv::Mat &blue, const cv::Mat &yellow)
+{
+    const auto start = std::chrono::steady_clock::now();
+    cv::cvtColor(input, referenceHsv, CV_BGR2HSV);
+    colorSeparator.detectBlueColor(referenceHsv, referenceBlue);
+    colorSeparator.detectYellowColor(referenceHsv, referenceYellow);
+    referenceTiming.Add(std::chrono::steady_clock::now() - start);
+
+    for (int y = 0; y < input.rows; y++)
+    {
+        const uchar *blueRow = blue.ptr<uchar>(y);
+        const uchar *yellowRow = yellow.ptr<uchar>(y);
+        const uchar *refBlue = referenceBlue.ptr<uchar>(y);
+        const uchar *refYellow = referenceYellow.ptr<uchar>(y);
+        for (int x = 0; x < input.cols; x++)
+        {
+            mismatches += (blueRow[x] != refBlue[x]) ? 1 : 0;
+            mismatches += (yellowRow[x] != refYellow[x]) ? 1 : 0;
+        }
+    }
+}
+
+void FramePipeline::verifyNoiseRemoval(const cv::Mat &threshold, const cv::Mat &denoised)
+{
+    noiseRemover.RemoveNoiseReference(threshold, referenceDenoised, referenceBlurred, referenceEroded);
+    // The binary and class engines only keep which pixels are set, not the blurred grey levels.
+    const bool binary = (noiseRemover.engine() != NoiseRemover::Engine::Filter);
+    for (int y = 0; y < denoised.rows; y++)
+    {
+        const uchar *row = denoised.ptr<uchar>(y);
+        const uchar *refRow = referenceDenoised.ptr<uchar>(y);
+        for (int x = 0; x < denoised.cols; x++)
+        {
+            const bool differs = binary ? ((row[x] != 0) != (refRow[x] != 0)) : (row[x] != refRow[x]);
+            denoiseMismatches += differs ? 1 : 0;
+        }
+    }
+}
+
+void FramePipeline::PrintTimings(std::ostream &out) const
+{
+    out << "Colour mode: " << colorModeName(colorStage) << ", noise removal: " << NoiseRemover::engineName(noiseRemover.engine())
+        << ", segmentation kernels: " << SegmentationKernels::activeName() << std::endl;
+    colorTiming.Print(out);
+    if (streamingTiming.count() > 0)
+    {
+        streamingTiming.Print(out);
+    }
+    if (coarseTiming.count() > 0)
+    {
+        coarseTiming.Print(out);
+    }
+    if (verify)
+    {
+        referenceTiming.Print(out);
+    }
+}
+
+bool FramePipeline::parseColorMode(const std::string &name, ColorMode &mode)
+{
+    if (name == "fused")
+    {
+        mode = ColorMode::Fused;
+    }
+    else if (name == "lut")
+    {
+        mode = ColorMode::Lut;
+    }
+    else if (name == "simd")
+    {
+        mode = ColorMode::Simd;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char *FramePipeline::colorModeName(ColorMode mode)
+{
+    switch (mode)
+    {
+    case ColorMode::Fused:
+        return "fused";
+    case ColorMode::Lut:
+        return "lut";
+    case ColorMode::Simd:
+        return "simd";
+    }
+    return "unknown";
+}
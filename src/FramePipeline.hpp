@@ -0,0 +1,225 @@
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "BlobExtractor.hpp"
+#include "ClassMaskFilter.hpp"
+#include "ColorLut.hpp"
+#include "ThreadPool.hpp"
+#include "TimingStats.hpp"
+
+// Owns every intermediate image of the colour separation and noise removal stages so that
+// they are allocated once and reused for all following frames of the same size. The masks
+// handed out stay valid until the next call to BeginFrame().
+//
+// The thresholded masks also act as a per-frame segmentation cache: they cover the whole frame,
+// and rows are converted and thresholded the first time any consumer (the steering path or the
+// direction check) asks for them. Every pixel is segmented at most once per frame.
+class FramePipeline
+{
+public:
+    enum class ColorMode
+    {
+        Fused, // Per-pixel HSV conversion and range checks (HsvColorSeparator::detectConeColors).
+        Lut,   // One lookup per pixel in a precomputed colour class table.
+        Simd   // cvtColor followed by the vectorized dual threshold (SegmentationKernels).
+    };
+
+    FramePipeline();
+    FramePipeline(const FramePipeline &) = delete;
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    // Switching to Lut builds the full table right away (a few hundred ms on the car).
+    void setColorMode(ColorMode mode);
+    ColorMode colorMode() const { return colorStage; }
+
+    // Starts a new frame; frame is the BGR(A) image all regions below refer to. Only the rows
+    // that are asked for have to hold valid pixels. Picks up thresholds published to the
+    // ParameterStore since the last frame.
+    void BeginFrame(const cv::Mat &frame);
+    // Thresholded (not denoised) masks of region, segmenting the rows not yet covered this frame.
+    // The returned views point into the cache.
+    cv::Mat segmentedYellow(const cv::Rect &region);
+    cv::Mat segmentedBlue(const cv::Rect &region);
+
+    // Runs the steering stages on region. With scale > 1 colour separation and noise removal run
+    // on a downscaled copy (not shared through the cache) and the masks are scaled back up.
+    void Process(const cv::Rect &region, int scale);
+
+    cv::Mat &blueMask() { return blueOutput; }
+    cv::Mat &yellowMask() { return yellowOutput; }
+
+    // Alternative to Process for large frames: every row of region is classified, denoised in a
+    // rolling window of rows (ClassMaskFilter) and fed to the blob extractors while it is still in
+    // cache. No mask image is written, so the memory use grows with the width only. Blobs are
+    // extracted from the first blobRows rows of region.
+    //
+    // With more than one thread the blob rows are split into horizontal stripes that run on a
+    // thread pool. Every stripe classifies DELAY extra rows on either side so its denoised rows do
+    // not depend on where it starts, and the blobs of neighbouring stripes are merged afterwards,
+    // so the blobs are the same for any number of threads.
+    void ProcessStreaming(const cv::Rect &region, int blobRows);
+    const std::vector<Blob> &blueBlobs() const { return streamedBlue; }
+    const std::vector<Blob> &yellowBlobs() const { return streamedYellow; }
+    // Threads used by ProcessStreaming, including the calling one. With --verify the stripes run
+    // one after another, as the verification is not thread-safe.
+    void setThreads(int threads);
+    int threads() const { return threadPool ? threadPool->threads() : 1; }
+
+    // ProcessStreaming restricted to windows of region (in region coordinates), for a tracker that
+    // knows where the cones will be. Every window is classified with the same halo as a stripe, so
+    // the denoised pixels inside it are the ones of a full pass; blobs are cut at the window edges.
+    // The blobs of all windows are concatenated in window order; windows should not overlap.
+    void ProcessWindows(const cv::Rect &region, const std::vector<cv::Rect> &searchWindows);
+    // Pixels classified by ProcessStreaming and ProcessWindows so far, halos included.
+    uint64_t streamedPixels() const { return pixelsStreamed; }
+
+    // Coarse-to-fine alternative to ProcessStreaming. The region is first downscaled by level
+    // (2 or 4) and streamed as a whole; blobs that are too small to be a cone at full resolution
+    // (AngleCalculator::MIN_CONE_AREA, with slack for the relatively stronger denoising of the
+    // coarse image) or far too large are dropped. Only the bounding boxes of the remaining
+    // candidates, grown by COARSE_MARGIN full-resolution pixels, are then streamed at full
+    // resolution (ProcessWindows), which gives their exact pixels and centroids. Cones that the
+    // coarse pass misses are not found, so the cost of a level is its speed and its missed cones.
+    // level 1 is the same as ProcessStreaming.
+    void ProcessCoarseToFine(const cv::Rect &region, int blobRows, int level);
+    // Candidates of the last coarse pass, in full-resolution region coordinates.
+    const std::vector<cv::Rect> &coarseCandidates() const { return candidateWindows; }
+
+    // Replaces windows that overlap or touch by their bounding box, so no blob is split between two.
+    static void mergeWindows(std::vector<cv::Rect> &rects);
+
+    // When enabled, every frame is also run through the reference OpenCV path (cvtColor + inRange)
+    // and the pixels where the optimized stages disagree are counted. Slow; for checking only.
+    void setVerify(bool enabled) { verify = enabled; }
+    uint64_t mismatchedPixels() const { return mismatches; }
+    // Same for the noise removal, compared against cv::erode / cv::dilate.
+    uint64_t mismatchedDenoisedPixels() const { return denoiseMismatches; }
+
+    // Timing of the colour separation stage, and of the reference path when verifying.
+    void PrintTimings(std::ostream &out) const;
+
+    static bool parseColorMode(const std::string &name, ColorMode &mode);
+    static const char *colorModeName(ColorMode mode);
+
+    uint64_t framesProcessed() const { return frames; }
+    // Number of frames where a buffer had to be reallocated although the input size and
+    // scale were the same as for the previous frame. Stays 0 at steady state.
+    uint64_t reallocations() const { return reallocatedFrames; }
+
+private:
+    static constexpr int BUFFER_COUNT = 15;
+    // State of one stripe of ProcessStreaming.
+    struct Stripe
+    {
+        Stripe();
+
+        ClassMaskFilter<uint8_t> filter;
+        BlobExtractor blueBlobs;
+        BlobExtractor yellowBlobs;
+        cv::Mat hsvRow;
+        cv::Mat blueRow;
+        cv::Mat yellowRow;
+        cv::Mat classRow;
+        std::vector<uint8_t> windowRow; // Denoised row with the halo columns cleared.
+    };
+
+    void trackBuffers(const cv::Size &inputSize, int scale);
+    void reserveStripes(int count);
+    // window plus the halo of input pixels its denoised pixels depend on, clipped to the region.
+    static cv::Rect inputWindow(const cv::Rect &window, const cv::Size &regionSize);
+    // Splits the first blobRows rows of pixels into one stripe per thread, streams them and merges
+    // the blobs of the stripes.
+    void streamStripes(const cv::Mat &pixels, int blobRows, bool useLut, std::vector<Blob> &blue, std::vector<Blob> &yellow);
+    // Runs streamWindow for every entry of windows, on the thread pool if there is one.
+    void streamWindows(const cv::Mat &pixels, bool useLut);
+    // Extracts the blobs of window (in the coordinates of pixels, the region's image) into stripe.
+    void streamWindow(Stripe &stripe, const cv::Mat &pixels, const cv::Rect &window, bool useLut);
+    void segmentRows(int rowBegin, int rowEnd);
+    // Lets the colour table catch up with the thresholds; returns whether the following
+    // separateColors calls can use the table.
+    bool prepareColorStage();
+    void separateColors(const cv::Mat &input, cv::Mat &blue, cv::Mat &yellow, cv::Mat &hsv, bool useLut);
+    void verifyColorSeparation(const cv::Mat &input, const cv::Mat &blue, const cv::Mat &yellow);
+    void verifyNoiseRemoval(const cv::Mat &threshold, const cv::Mat &denoised);
+    // Class-bit mask for NoiseRemover::RemoveNoiseClasses and back.
+    static void mergeClasses(const cv::Mat &blue, const cv::Mat &yellow, cv::Mat &classes);
+    static void splitClasses(const cv::Mat &classes, cv::Mat &blue, cv::Mat &yellow);
+    static constexpr uchar BLUE_CLASS = 1;
+    static constexpr uchar YELLOW_CLASS = 2;
+    // Full-resolution pixels added around a coarse candidate on every side, on top of the level.
+    static constexpr int COARSE_MARGIN = 4;
+    // Keeps the coarse blobs that may be cones at full resolution as candidate windows.
+    void addCandidates(const std::vector<Blob> &blobs, int level, const cv::Size &bounds);
+
+    // Colour table slabs rebuilt per frame after a threshold change; the fused path is used meanwhile.
+    static constexpr int LUT_SLABS_PER_FRAME = 16;
+
+    ColorMode colorStage{ColorMode::Fused};
+    std::unique_ptr<ColorLut> colorLut;
+    TimingStats colorTiming;
+    TimingStats referenceTiming;
+    TimingStats streamingTiming;
+    TimingStats coarseTiming;
+
+    cv::Mat frameInput;
+    // Rows [coveredBegin, coveredEnd) of the frame are in the cache.
+    int coveredBegin{0};
+    int coveredEnd{0};
+
+    cv::Mat scaledInput;
+    cv::Mat hsvImg;
+    cv::Mat blueThresh;
+    cv::Mat yellowThresh;
+    cv::Mat scaledHsv;
+    cv::Mat scaledBlueThresh;
+    cv::Mat scaledYellowThresh;
+    cv::Mat blurred;
+    cv::Mat eroded;
+    cv::Mat blueDenoised;
+    cv::Mat yellowDenoised;
+    cv::Mat classThresh;
+    cv::Mat classDenoised;
+    cv::Mat blueRescaled;
+    cv::Mat yellowRescaled;
+    cv::Mat blueOutput;
+    cv::Mat yellowOutput;
+    // ProcessStreaming.
+    std::unique_ptr<ThreadPool> threadPool;
+    std::vector<std::unique_ptr<Stripe>> stripes;
+    std::vector<cv::Rect> windows; // Window of every stripe in use.
+    std::vector<const BlobExtractor *> stripeBlobs;
+    BlobStripeMerger stripeMerger;
+    std::vector<Blob> streamedBlue;
+    std::vector<Blob> streamedYellow;
+    // ProcessCoarseToFine.
+    cv::Mat coarseInput;
+    std::vector<Blob> coarseBlue;
+    std::vector<Blob> coarseYellow;
+    std::vector<cv::Rect> candidateWindows;
+
+    cv::Mat referenceHsv;
+    cv::Mat referenceBlue;
+    cv::Mat referenceYellow;
+    cv::Mat referenceBlurred;
+    cv::Mat referenceEroded;
+    cv::Mat referenceDenoised;
+
+    const uint8_t *bufferData[BUFFER_COUNT];
+    cv::Size lastSize;
+    int lastScale{0};
+    bool verify{false};
+    uint64_t mismatches{0};
+    uint64_t denoiseMismatches{0};
+    uint64_t frames{0};
+    uint64_t reallocatedFrames{0};
+    uint64_t thresholdsVersion{0};
+    uint64_t pixelsStreamed{0};
+};
+
+#endif // FRAME_PIPELINE_HPP
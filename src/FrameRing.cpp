@@ -0,0 +1,33 @@
+#include "FrameRing.hpp"
+
+FrameRing::FrameRing(int rows, int cols, int type)
+    : slots()
+{
+    for (Frame &slot : slots)
+    {
+        slot.pixels.create(rows, cols, type);
+    }
+}
+
+void FrameRing::Publish()
+{
+    const uint8_t previous = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel);
+    if (previous & FRESH)
+    {
+        // The consumer never saw the frame that was waiting in the middle slot.
+        droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+    back = static_cast<uint8_t>(previous & INDEX_MASK);
+    publishedFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool FrameRing::Acquire()
+{
+    if (!(middle.load(std::memory_order_relaxed) & FRESH))
+    {
+        return false;
+    }
+    const uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+    front = static_cast<uint8_t>(previous & INDEX_MASK);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef FRAME_RING_HPP
+#define FRAME_RING_HPP
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+
+// One captured frame together with where it came from.
+struct Frame
+{
+    cv::Mat pixels{};
+    uint64_t sequence{0};        // Counts every frame the producer captured, starting at 1.
+    int64_t sampleTimePoint{0};  // Sample time from the shared memory, in microseconds.
+    bool fullFrame{false};       // False if only the bottom half of pixels was copied.
+};
+
+// Lock-free triple buffer between one producer and one consumer. The producer always has
+// a slot to write into and the consumer always has a slot to read from; the third slot is
+// exchanged atomically. If the producer publishes again before the consumer picked up the
+// previous frame, that frame is overwritten (latest frame wins) and counted as dropped.
+class FrameRing
+{
+public:
+    FrameRing(int rows, int cols, int type);
+
+    // Producer side.
+    Frame &writeSlot() { return slots[back]; }
+    void Publish();
+
+    // Consumer side. Returns false without blocking if nothing new was published.
+    bool Acquire();
+    const Frame &readSlot() const { return slots[front]; }
+
+    uint64_t published() const { return publishedFrames.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    Frame slots[3];
+    uint8_t back{0};
+    uint8_t front{1};
+    std::atomic<uint8_t> middle{2};
+    std::atomic<uint64_t> publishedFrames{0};
+    std::atomic<uint64_t> droppedFrames{0};
+};
+
+#endif // FRAME_RING_HPP
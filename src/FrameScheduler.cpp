@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include "FrameScheduler.hpp"
+
+namespace
+{
+// Weight of the newest sample in the running estimates.
+constexpr double ESTIMATE_ALPHA = 0.2;
+constexpr int MAX_SCALE = 4;
+} // namespace
+
+FrameScheduler::FrameScheduler(Policy policy, int64_t cameraPeriodMicroseconds)
+    : schedulePolicy(policy),
+      cameraPeriod(std::max<int64_t>(1, cameraPeriodMicroseconds))
+{
+}
+
+FrameScheduler::Decision FrameScheduler::Decide(uint64_t sequence, int64_t sampleTimePoint, int64_t now)
+{
+    // Follow the real camera period from the sample time stamps once they are available.
+    if (lastSampleTimePoint > 0 && sampleTimePoint > lastSampleTimePoint)
+    {
+        const double delta = static_cast<double>(sampleTimePoint - lastSampleTimePoint);
+        cameraPeriod = std::max<int64_t>(1, static_cast<int64_t>((1.0 - ESTIMATE_ALPHA) * static_cast<double>(cameraPeriod) + ESTIMATE_ALPHA * delta));
+    }
+    lastSampleTimePoint = sampleTimePoint;
+
+    Decision decision{true, 1};
+    switch (schedulePolicy)
+    {
+    case Policy::None:
+        break;
+    case Policy::ProcessLatest:
+    {
+        // Replayed recordings carry their original sample times, so the age is measured relative to the
+        // smallest offset between our clock and the sample times seen so far.
+        const int64_t offset = now - sampleTimePoint;
+        if (!haveClockOffset || offset < clockOffset)
+        {
+            clockOffset = offset;
+            haveClockOffset = true;
+        }
+        // A newer frame is already due, so spending a full processing run on this one only adds latency.
+        if (offset - clockOffset > cameraPeriod)
+        {
+            decision.process = false;
+            staleFrames++;
+        }
+        break;
+    }
+    case Policy::EveryNth:
+    {
+        const uint64_t n = static_cast<uint64_t>(std::max(1.0, std::ceil(costEstimate / static_cast<double>(cameraPeriod))));
+        if (lastProcessedSequence > 0 && sequence - lastProcessedSequence < n)
+        {
+            decision.process = false;
+        }
+        break;
+    }
+    case Policy::DegradeResolution:
+        // Cost is measured at the current scale; step down while over budget, back up with plenty of headroom.
+        if (costEstimate > 0.9 * static_cast<double>(cameraPeriod) && scale < MAX_SCALE)
+        {
+            scale *= 2;
+            costEstimate /= 4.0;
+        }
+        else if (costEstimate < 0.2 * static_cast<double>(cameraPeriod) && scale > 1)
+        {
+            scale /= 2;
+            costEstimate *= 4.0;
+        }
+        decision.scale = scale;
+        if (scale > 1)
+        {
+            degradedFrames++;
+        }
+        break;
+    }
+
+    if (decision.process)
+    {
+        lastProcessedSequence = sequence;
+        processedFrames++;
+    }
+    else
+    {
+        droppedFrames++;
+    }
+    return decision;
+}
+
+void FrameScheduler::FrameProcessed(int64_t costMicroseconds)
+{
+    const double cost = static_cast<double>(costMicroseconds);
+    costEstimate = (costEstimate <= 0.0) ? cost : (1.0 - ESTIMATE_ALPHA) * costEstimate + ESTIMATE_ALPHA * cost;
+}
+
+void FrameScheduler::FramesReplaced(uint64_t count)
+{
+    replacedFrames += count;
+}
+
+void FrameScheduler::Print(std::ostream &out) const
+{
+    out << "Scheduler '" << policyName(schedulePolicy) << "': period=" << cameraPeriod << "us cost=" << estimatedCost()
+        << "us processed=" << processedFrames << " dropped=" << dropped() << " (skipped=" << droppedFrames
+        << ", stale=" << staleFrames << ", replaced by newer=" << replacedFrames << ")";
+    if (schedulePolicy == Policy::DegradeResolution)
+    {
+        out << " degraded=" << degradedFrames << " scale=" << scale;
+    }
+    out << std::endl;
+}
+
+bool FrameScheduler::parsePolicy(const std::string &name, Policy &policy)
+{
+    if (name == "none")
+    {
+        policy = Policy::None;
+    }
+    else if (name == "latest")
+    {
+        policy = Policy::ProcessLatest;
+    }
+    else if (name == "nth")
+    {
+        policy = Policy::EveryNth;
+    }
+    else if (name == "degrade")
+    {
+        policy = Policy::DegradeResolution;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char *FrameScheduler::policyName(Policy policy)
+{
+    switch (policy)
+    {
+    case Policy::None:
+        return "none";
+    case Policy::ProcessLatest:
+        return "latest";
+    case Policy::EveryNth:
+        return "nth";
+    case Policy::DegradeResolution:
+        return "degrade";
+    }
+    return "unknown";
+}
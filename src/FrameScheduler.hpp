@@ -0,0 +1,65 @@
+#ifndef FRAME_SCHEDULER_HPP
+#define FRAME_SCHEDULER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Decides per frame whether (and at which resolution) it should be processed, so that the
+// steering output does not fall further and further behind the camera when processing a
+// frame takes longer than the camera period.
+class FrameScheduler
+{
+public:
+    enum class Policy
+    {
+        None,             // Process every frame (original behaviour).
+        ProcessLatest,    // Skip frames that are already older than one camera period.
+        EveryNth,         // Process every Nth frame, N derived from processing cost / period.
+        DegradeResolution // Process every frame, but at reduced resolution while over budget.
+    };
+
+    struct Decision
+    {
+        bool process;
+        int scale; // Downscale factor for the colour/noise stages (1 = full resolution).
+    };
+
+    FrameScheduler(Policy policy, int64_t cameraPeriodMicroseconds);
+
+    // sequence counts captured frames, sampleTimePoint/now are in microseconds.
+    Decision Decide(uint64_t sequence, int64_t sampleTimePoint, int64_t now);
+    // Reports the processing cost of the last frame Decide() let through.
+    void FrameProcessed(int64_t costMicroseconds);
+    // Frames that never reached Decide() because a newer frame replaced them.
+    void FramesReplaced(uint64_t count);
+
+    Policy policy() const { return schedulePolicy; }
+    int64_t period() const { return cameraPeriod; }
+    int64_t estimatedCost() const { return static_cast<int64_t>(costEstimate); }
+    // Frames skipped by the policy plus frames replaced by a newer one before they were seen.
+    uint64_t dropped() const { return droppedFrames + replacedFrames; }
+
+    void Print(std::ostream &out) const;
+
+    static bool parsePolicy(const std::string &name, Policy &policy);
+    static const char *policyName(Policy policy);
+
+private:
+    Policy schedulePolicy;
+    int64_t cameraPeriod;
+    double costEstimate{0.0};
+    int64_t lastSampleTimePoint{0};
+    int64_t clockOffset{0};
+    bool haveClockOffset{false};
+    uint64_t lastProcessedSequence{0};
+    int scale{1};
+
+    uint64_t processedFrames{0};
+    uint64_t droppedFrames{0};
+    uint64_t staleFrames{0};
+    uint64_t replacedFrames{0};
+    uint64_t degradedFrames{0};
+};
+
+#endif // FRAME_SCHEDULER_HPP
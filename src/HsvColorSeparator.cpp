@@ -1,67 +1,72 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include "HsvColorSeparator.hpp"
+#include "HsvConversion.hpp"
+#include "SegmentationKernels.hpp"
 
-int iLowH = 90;
-int iHighH = 135;
+HsvColorSeparator::HsvColorSeparator() : current(defaultThresholds()) {};
 
-int iLowS = 44;
-int iHighS = 255;
-
-int iLowV = 45;
-int iHighV = 255;
-
-int yellowLowH = 15;
-int yellowHighH = 30;
-
-int yellowLowS = 42;
-int yellowHighS = 255;
-
-int yellowLowV = 46;
-int yellowHighV = 255;
-
-HsvColorSeparator::HsvColorSeparator(){};
+HsvThresholds HsvColorSeparator::defaultThresholds()
+{
+    // {lowH, highH, lowS, highS, lowV, highV}
+    HsvThresholds defaults{};
+    defaults.blue = HsvRange{90, 135, 44, 255, 45, 255};
+    defaults.yellow = HsvRange{15, 30, 42, 255, 46, 255};
+    return defaults;
+}
 
-cv::Mat HsvColorSeparator::detectBlueColor(const cv::Mat &inputFrame, bool VERBOSE)
+cv::Mat HsvColorSeparator::detectBlueColor(const cv::Mat &inputFrame)
 {
     cv::Mat mask;
-    cv::inRange(inputFrame, cv::Scalar(iLowH, iLowS, iLowV), cv::Scalar(iHighH, iHighS, iHighV), mask);
-
-    // Add trackbars for manually adjusting HSV during runtime. Makes it easier to experiment with filters and finding
-    // the correct HSV values.
-    if (VERBOSE)
-    {
-        cv::namedWindow("BlueTrackingControl", cv::WINDOW_AUTOSIZE);
-        cv::createTrackbar("LowH", "BlueTrackingControl", &iLowH, 179); // Hue (0 - 179)
-        cv::createTrackbar("HighH", "BlueTrackingControl", &iHighH, 179);
-        cv::createTrackbar("LowS", "BlueTrackingControl", &iLowS, 255); // Saturation (0 - 255)
-        cv::createTrackbar("HighS", "BlueTrackingControl", &iHighS, 255);
-        cv::createTrackbar("LowV", "BlueTrackingControl", &iLowV, 255); // Value (0 - 255)
-        cv::createTrackbar("HighV", "BlueTrackingControl", &iHighV, 255);
-    }
+    detectBlueColor(inputFrame, mask);
     return mask;
 }
 
-cv::Mat HsvColorSeparator::detectYellowColor(const cv::Mat &inputFrame, bool VERBOSE)
+cv::Mat HsvColorSeparator::detectYellowColor(const cv::Mat &inputFrame)
 {
     cv::Mat mask;
-    cv::inRange(inputFrame, cv::Scalar(yellowLowH, yellowLowS, yellowLowV), cv::Scalar(yellowHighH, yellowHighS, yellowHighV), mask);
+    detectYellowColor(inputFrame, mask);
+    return mask;
+}
 
-    // Add trackbars for manually adjusting HSV during runtime. Makes it easier to experiment with filters and finding
-    // the correct HSV values.
-    if (VERBOSE)
-    {
+void HsvColorSeparator::detectBlueColor(const cv::Mat &inputFrame, cv::Mat &mask)
+{
+    const HsvRange &blue = current.blue;
+    cv::inRange(inputFrame, cv::Scalar(blue.lowH, blue.lowS, blue.lowV), cv::Scalar(blue.highH, blue.highS, blue.highV), mask);
+}
 
-        cv::namedWindow("YellowTrackingControl", cv::WINDOW_AUTOSIZE);
-        cv::createTrackbar("LowH", "YellowTrackingControl", &yellowLowH, 179); // Hue (0 - 179)
-        cv::createTrackbar("HighH", "YellowTrackingControl", &yellowHighH, 179);
+void HsvColorSeparator::detectYellowColor(const cv::Mat &inputFrame, cv::Mat &mask)
+{
+    const HsvRange &yellow = current.yellow;
+    cv::inRange(inputFrame, cv::Scalar(yellow.lowH, yellow.lowS, yellow.lowV), cv::Scalar(yellow.highH, yellow.highS, yellow.highV), mask);
+}
 
-        cv::createTrackbar("LowS", "YellowTrackingControl", &yellowLowS, 255); // Saturation (0 - 255)
-        cv::createTrackbar("HighS", "YellowTrackingControl", &yellowHighS, 255);
+void HsvColorSeparator::detectConeColors(const cv::Mat &bgrFrame, cv::Mat &blueMask, cv::Mat &yellowMask)
+{
+    blueMask.create(bgrFrame.rows, bgrFrame.cols, CV_8UC1);
+    yellowMask.create(bgrFrame.rows, bgrFrame.cols, CV_8UC1);
 
-        cv::createTrackbar("LowV", "YellowTrackingControl", &yellowLowV, 255); // Value (0 - 255)
-        cv::createTrackbar("HighV", "YellowTrackingControl", &yellowHighV, 255);
+    // Local copy, so the compiler can keep the bounds in registers.
+    const HsvThresholds bounds = current;
+
+    const HsvConversion &hsv = HsvConversion::instance();
+    const int channels = bgrFrame.channels();
+    for (int y = 0; y < bgrFrame.rows; y++)
+    {
+        const uchar *src = bgrFrame.ptr<uchar>(y);
+        uchar *blueRow = blueMask.ptr<uchar>(y);
+        uchar *yellowRow = yellowMask.ptr<uchar>(y);
+        for (int x = 0; x < bgrFrame.cols; x++, src += channels)
+        {
+            int h, s, v;
+            hsv.toHsv(src[0], src[1], src[2], h, s, v);
+            blueRow[x] = bounds.blue.contains(h, s, v) ? 255 : 0;
+            yellowRow[x] = bounds.yellow.contains(h, s, v) ? 255 : 0;
+        }
     }
+}
 
-    return mask;
+void HsvColorSeparator::detectConeColorsHsv(const cv::Mat &hsvFrame, cv::Mat &blueMask, cv::Mat &yellowMask)
+{
+    SegmentationKernels::Threshold(hsvFrame, current, blueMask, yellowMask);
 }
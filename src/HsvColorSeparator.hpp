@@ -4,12 +4,58 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+// Inclusive HSV bounds of one cone colour, as used by cv::inRange.
+struct HsvRange
+{
+    int lowH, highH;
+    int lowS, highS;
+    int lowV, highV;
+
+    bool contains(int h, int s, int v) const
+    {
+        return h >= lowH && h <= highH && s >= lowS && s <= highS && v >= lowV && v <= highV;
+    }
+    bool operator==(const HsvRange &other) const
+    {
+        return lowH == other.lowH && highH == other.highH && lowS == other.lowS && highS == other.highS &&
+               lowV == other.lowV && highV == other.highV;
+    }
+    bool operator!=(const HsvRange &other) const { return !(*this == other); }
+};
+
+struct HsvThresholds
+{
+    HsvRange blue;
+    HsvRange yellow;
+
+    bool operator==(const HsvThresholds &other) const { return blue == other.blue && yellow == other.yellow; }
+    bool operator!=(const HsvThresholds &other) const { return !(*this == other); }
+};
+
 class HsvColorSeparator
 {
 public:
     HsvColorSeparator();
-    cv::Mat detectBlueColor(const cv::Mat &inputFrame, bool VERBOSE);
-    cv::Mat detectYellowColor(const cv::Mat &inputFrame, bool VERBOSE);
+    // The thresholds currently in use. They are only changed between frames, by FramePipeline
+    // picking up a new snapshot from the ParameterStore.
+    HsvThresholds thresholds() const { return current; }
+    void setThresholds(const HsvThresholds &thresholds) { current = thresholds; }
+    // Values the car starts with; the trackbars of the debug UI start from these too.
+    static HsvThresholds defaultThresholds();
+    cv::Mat detectBlueColor(const cv::Mat &inputFrame);
+    cv::Mat detectYellowColor(const cv::Mat &inputFrame);
+    // Same as above, but write into mask, which is only (re)allocated if its size or type does not fit.
+    void detectBlueColor(const cv::Mat &inputFrame, cv::Mat &mask);
+    void detectYellowColor(const cv::Mat &inputFrame, cv::Mat &mask);
+    // Fused version of cvtColor(CV_BGR2HSV) followed by detectBlueColor and detectYellowColor: reads
+    // the BGR or BGRA frame once and writes both masks without an intermediate HSV image.
+    // The masks are bit-identical to the ones of the separate stages.
+    void detectConeColors(const cv::Mat &bgrFrame, cv::Mat &blueMask, cv::Mat &yellowMask);
+    // Both masks from an already converted HSV frame in one vectorized pass (SegmentationKernels).
+    void detectConeColorsHsv(const cv::Mat &hsvFrame, cv::Mat &blueMask, cv::Mat &yellowMask);
+
+private:
+    HsvThresholds current;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include <cmath>
+#include "HsvConversion.hpp"
+
+HsvConversion::HsvConversion()
+    : sdiv(),
+      hdiv()
+{
+    // Same fixed-point division tables as OpenCV's RGB2HSV_b with a hue range of 180.
+    sdiv[0] = hdiv[0] = 0;
+    for (int i = 1; i < 256; i++)
+    {
+        sdiv[i] = static_cast<int>(std::lrint((255 << SHIFT) / (1. * i)));
+        hdiv[i] = static_cast<int>(std::lrint((180 << SHIFT) / (6. * i)));
+    }
+}
+
+const HsvConversion &HsvConversion::instance()
+{
+    static const HsvConversion conversion;
+    return conversion;
+}
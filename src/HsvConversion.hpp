@@ -0,0 +1,39 @@
+#ifndef HSV_CONVERSION_HPP
+#define HSV_CONVERSION_HPP
+
+#include <cstdint>
+
+// Integer BGR -> HSV conversion for 8-bit pixels that reproduces cv::cvtColor(..., CV_BGR2HSV)
+// exactly (H in 0..180, S and V in 0..255), so single pixels can be classified without
+// materializing an HSV image.
+class HsvConversion
+{
+public:
+    static const HsvConversion &instance();
+
+    inline void toHsv(int b, int g, int r, int &h, int &s, int &v) const
+    {
+        v = b > g ? b : g;
+        v = v > r ? v : r;
+        int vmin = b < g ? b : g;
+        vmin = vmin < r ? vmin : r;
+
+        const int diff = v - vmin;
+        const int vr = v == r ? -1 : 0;
+        const int vg = v == g ? -1 : 0;
+
+        s = (diff * sdiv[v] + (1 << (SHIFT - 1))) >> SHIFT;
+        h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+        h = (h * hdiv[diff] + (1 << (SHIFT - 1))) >> SHIFT;
+        h += h < 0 ? 180 : 0;
+    }
+
+private:
+    static constexpr int SHIFT = 12;
+    HsvConversion();
+
+    int sdiv[256];
+    int hdiv[256];
+};
+
+#endif // HSV_CONVERSION_HPP
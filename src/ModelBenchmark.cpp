@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include "ModelBenchmark.hpp"
+
+int ModelBenchmark::Run(const std::string &modelPath, const std::string &csvPath, std::ostream &out)
+{
+    SteeringModel model;
+    std::vector<double> features;
+    std::vector<double> expected;
+    if (!model.Load(modelPath, out) || !readRows(csvPath, features, expected, out))
+    {
+        return 1;
+    }
+    const int rows = static_cast<int>(expected.size());
+    out << "Steering model: " << model.treeCount() << " trees, " << model.nodeCount() << " nodes, " << model.featureCount()
+        << " features; " << rows << " feature rows" << std::endl;
+
+    bool identical = true;
+    std::vector<double> predictions(expected.size());
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(rows) * PASSES);
+    for (SteeringModel::Layout layout : {SteeringModel::FLOAT_THRESHOLDS, SteeringModel::THRESHOLD_RANKS, SteeringModel::BITVECTORS})
+    {
+        if (!model.setLayout(layout))
+        {
+            out << SteeringModel::layoutName(layout) << ": not possible for this model." << std::endl;
+            continue;
+        }
+
+        int mismatches = 0;
+        latencies.clear();
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            for (int i = 0; i < rows; i++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const double prediction = model.Predict(&features[static_cast<size_t>(i) * SteeringModel::FEATURE_COUNT]);
+                latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+                if (pass == 0 && std::abs(prediction - expected[static_cast<size_t>(i)]) > TOLERANCE)
+                {
+                    mismatches++;
+                }
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p / 100.0 * static_cast<double>(latencies.size() - 1))]; };
+
+        const auto batchStart = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            model.PredictBatch(features.data(), rows, predictions.data());
+        }
+        const double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        for (int i = 0; i < rows; i++)
+        {
+            mismatches += (std::abs(predictions[static_cast<size_t>(i)] - expected[static_cast<size_t>(i)]) > TOLERANCE) ? 1 : 0;
+        }
+
+        identical = identical && (mismatches == 0);
+        out << SteeringModel::layoutName(layout) << " (" << model.modelBytes() << " bytes): single prediction p50 "
+            << percentile(50.0) << " ns, p99 " << percentile(99.0) << " ns, max " << latencies.back() << " ns; batch "
+            << static_cast<double>(rows) * PASSES / batchSeconds << " predictions/s; mismatches with sklearn: " << mismatches << std::endl;
+    }
+    return identical ? 0 : 1;
+}
+
+bool ModelBenchmark::readRows(const std::string &path, std::vector<double> &features, std::vector<double> &expected, std::ostream &out)
+{
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line))
+    {
+        out << "Model benchmark: cannot read '" << path << "'." << std::endl;
+        return false;
+    }
+    // Header, then FEATURE_COUNT features and the expected prediction per line; "nan" for missing values.
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string field;
+        int column = 0;
+        while (std::getline(fields, field, ',') && column <= SteeringModel::FEATURE_COUNT)
+        {
+            const double value = (field.empty() || field == "nan") ? std::numeric_limits<double>::quiet_NaN() : std::stod(field);
+            (column < SteeringModel::FEATURE_COUNT ? features : expected).push_back(value);
+            column++;
+        }
+        if (column != SteeringModel::FEATURE_COUNT + 1)
+        {
+            out << "Model benchmark: '" << path << "' has a line with " << column << " columns, expected " << SteeringModel::FEATURE_COUNT + 1 << "." << std::endl;
+            return false;
+        }
+    }
+    return !expected.empty();
+}
@@ -0,0 +1,29 @@
+#ifndef MODEL_BENCHMARK_HPP
+#define MODEL_BENCHMARK_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "SteeringModel.hpp"
+
+// Offline benchmark of SteeringModel on recorded sensor data: reads the feature rows and sklearn
+// predictions written by LRegressionModel/benchmark_model.py (which also times the joblib model
+// on the same rows), checks that the native predictions match, and reports the latency of single
+// predictions and the throughput of PredictBatch in every layout the model fits.
+class ModelBenchmark
+{
+public:
+    // Returns 0 if every prediction matched sklearn in every layout.
+    static int Run(const std::string &modelPath, const std::string &csvPath, std::ostream &out);
+
+private:
+    static constexpr int PASSES = 20;
+    // sklearn's predictions are written with 17 significant digits; the sum over the trees may
+    // round differently.
+    static constexpr double TOLERANCE = 1e-9;
+
+    // Rows of SteeringModel::FEATURE_COUNT features followed by the expected prediction.
+    static bool readRows(const std::string &path, std::vector<double> &features, std::vector<double> &expected, std::ostream &out);
+};
+
+#endif // MODEL_BENCHMARK_HPP
@@ -1,8 +1,43 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <cstring>
 #include "NoiseRemover.hpp"
+#include "SegmentationKernels.hpp"
 
-NoiseRemover::NoiseRemover(){};
+namespace
+{
+template <typename T>
+void removeNoiseClasses(const cv::Mat &input, cv::Mat &output, ClassMaskFilter<T> &filter)
+{
+    const size_t rowBytes = sizeof(T) * static_cast<size_t>(input.cols);
+    filter.Begin(input.cols, input.rows);
+    for (int y = 0; y < input.rows; y++)
+    {
+        const int ready = filter.PushRow(input.ptr<T>(y));
+        if (ready >= 0)
+        {
+            std::memcpy(output.ptr<T>(ready), filter.outputRow(), rowBytes);
+        }
+    }
+    for (int ready = filter.Flush(); ready >= 0; ready = filter.Flush())
+    {
+        std::memcpy(output.ptr<T>(ready), filter.outputRow(), rowBytes);
+    }
+}
+} // namespace
+
+NoiseRemover::NoiseRemover()
+    : kernel(cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3))),
+      packed(),
+      blurredBits(),
+      erodedBits(),
+      openedBits(),
+      blurSums(),
+      classFilter8(),
+      classFilter16(),
+      classFilter32()
+{
+}
 
 cv::Mat NoiseRemover::RemoveNoise(const cv::Mat &inputFrame) {
     if(inputFrame.empty()){
@@ -10,13 +45,110 @@ cv::Mat NoiseRemover::RemoveNoise(const cv::Mat &inputFrame) {
     }
 
     cv::Mat outputFrame;
-    cv::GaussianBlur(inputFrame, outputFrame, cv::Size(5, 5), 0);  // Increased blur
-
+    cv::Mat blurred;
     cv::Mat eroded;
-    cv::erode(outputFrame, eroded, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3)));
+    RemoveNoise(inputFrame, outputFrame, blurred, eroded);
+    return outputFrame;  // Return the processed frame
+}
+
+void NoiseRemover::RemoveNoise(const cv::Mat &inputFrame, cv::Mat &outputFrame, cv::Mat &blurred, cv::Mat &eroded) {
+    if(inputFrame.empty()){
+        outputFrame.release();  // Handle empty input
+        return;
+    }
+
+    if (activeEngine == Engine::Binary)
+    {
+        removeNoiseBinary(inputFrame, outputFrame);
+        return;
+    }
+    if (activeEngine == Engine::Classes)
+    {
+        // A 0/255 mask is a class mask with every class bit set.
+        RemoveNoiseClasses(inputFrame, outputFrame);
+        return;
+    }
+
+    // Isolated border: a view into a larger mask is filtered as if it were an image of its own.
+    // Same pixels as cv::GaussianBlur (RemoveNoiseReference), without its per-call row buffers.
+    SegmentationKernels::GaussianBlur5x5(inputFrame, blurred, blurSums);  // Increased blur
+    SegmentationKernels::Erode(blurred, eroded);
+    SegmentationKernels::Dilate(eroded, outputFrame);
+}
+
+void NoiseRemover::RemoveNoiseReference(const cv::Mat &inputFrame, cv::Mat &outputFrame, cv::Mat &blurred, cv::Mat &eroded) {
+    if(inputFrame.empty()){
+        outputFrame.release();
+        return;
+    }
+
+    cv::GaussianBlur(inputFrame, blurred, cv::Size(5, 5), 0, 0, cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+    cv::erode(blurred, eroded, kernel, cv::Point(-1, -1), 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+    cv::dilate(eroded, outputFrame, kernel, cv::Point(-1, -1), 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+}
+
+void NoiseRemover::removeNoiseBinary(const cv::Mat &inputFrame, cv::Mat &outputFrame) {
+    // Only whether a blurred pixel is nonzero matters for the contours, and it is nonzero exactly
+    // when there is a mask pixel in its 5x5 neighbourhood.
+    packed.Pack(inputFrame);
+    BinaryMask::DilateSquare(packed, blurredBits, 2);
+    BinaryMask::Open(blurredBits, openedBits, erodedBits);
+    openedBits.Unpack(outputFrame);
+}
 
-    cv::Mat dilated;
-    cv::dilate(eroded, dilated, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3)));
-    
-    return dilated;  // Return the processed frame
+void NoiseRemover::RemoveNoiseClasses(const cv::Mat &classMask, cv::Mat &outputMask) {
+    CV_Assert(classMask.type() == CV_8UC1 || classMask.type() == CV_16UC1 || classMask.type() == CV_32SC1);
+    CV_Assert(classMask.data != outputMask.data || classMask.empty());
+    outputMask.create(classMask.rows, classMask.cols, classMask.type());
+    if(classMask.empty()){
+        return;
+    }
+
+    switch (classMask.type())
+    {
+    case CV_8UC1:
+        removeNoiseClasses(classMask, outputMask, classFilter8);
+        break;
+    case CV_16UC1:
+        removeNoiseClasses(classMask, outputMask, classFilter16);
+        break;
+    case CV_32SC1:
+        removeNoiseClasses(classMask, outputMask, classFilter32);
+        break;
+    }
+}
+
+bool NoiseRemover::parseEngine(const std::string &name, Engine &noiseEngine)
+{
+    if (name == "filter")
+    {
+        noiseEngine = Engine::Filter;
+    }
+    else if (name == "binary")
+    {
+        noiseEngine = Engine::Binary;
+    }
+    else if (name == "classes")
+    {
+        noiseEngine = Engine::Classes;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char *NoiseRemover::engineName(Engine noiseEngine)
+{
+    switch (noiseEngine)
+    {
+    case Engine::Filter:
+        return "filter";
+    case Engine::Binary:
+        return "binary";
+    case Engine::Classes:
+        return "classes";
+    }
+    return "unknown";
 }
@@ -3,11 +3,54 @@
 
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BinaryMask.hpp"
+#include "ClassMaskFilter.hpp"
 
 class NoiseRemover{
     public:
+        enum class Engine
+        {
+            Filter, // GaussianBlur + erode + dilate on 8-bit masks; the output keeps the blurred grey levels.
+            Binary, // The same on bit-packed masks (BinaryMask); 0/255 output with the same nonzero pixels.
+            Classes // Blue and yellow merged into one class-bit mask and denoised together (RemoveNoiseClasses).
+        };
+
         NoiseRemover();
+        void setEngine(Engine noiseEngine) { activeEngine = noiseEngine; }
+        Engine engine() const { return activeEngine; }
+
         cv::Mat RemoveNoise(const cv::Mat &inputFrame);
+        // Same as above with caller-owned buffers; none of them is reallocated if its size already fits.
+        void RemoveNoise(const cv::Mat &inputFrame, cv::Mat &outputFrame, cv::Mat &blurred, cv::Mat &eroded);
+        // Same result using cv::GaussianBlur / cv::erode / cv::dilate instead of the SegmentationKernels, for --verify.
+        void RemoveNoiseReference(const cv::Mat &inputFrame, cv::Mat &outputFrame, cv::Mat &blurred, cv::Mat &eroded);
+
+        // Denoises a class-bit mask, where bit k of a pixel is set if it belongs to cone class k, for
+        // all classes in a single traversal. CV_8UC1 holds up to 8 classes, CV_16UC1 up to 16 and
+        // CV_32SC1 up to 32. A class bit is set in the output exactly where RemoveNoise on that class
+        // alone gives a nonzero pixel, so a 0/255 mask comes out as a 0/255 mask.
+        void RemoveNoiseClasses(const cv::Mat &classMask, cv::Mat &outputMask);
+
+        static bool parseEngine(const std::string &name, Engine &noiseEngine);
+        static const char *engineName(Engine noiseEngine);
+
+    private:
+        void removeNoiseBinary(const cv::Mat &inputFrame, cv::Mat &outputFrame);
+
+        cv::Mat kernel;
+        Engine activeEngine{Engine::Filter};
+        BinaryMask packed;
+        BinaryMask blurredBits;
+        BinaryMask erodedBits;
+        BinaryMask openedBits;
+        std::vector<uint16_t> blurSums; // Scratch of SegmentationKernels::GaussianBlur5x5.
+        // Rolling row buffers of RemoveNoiseClasses, one per class mask type.
+        ClassMaskFilter<uint8_t> classFilter8;
+        ClassMaskFilter<uint16_t> classFilter16;
+        ClassMaskFilter<int32_t> classFilter32;
     };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,69 @@
+#include "ParameterStore.hpp"
+
+namespace
+{
+void toValues(const HsvRange &range, int *values)
+{
+    values[0] = range.lowH;
+    values[1] = range.highH;
+    values[2] = range.lowS;
+    values[3] = range.highS;
+    values[4] = range.lowV;
+    values[5] = range.highV;
+}
+
+HsvRange fromValues(const int *values)
+{
+    return HsvRange{values[0], values[1], values[2], values[3], values[4], values[5]};
+}
+} // namespace
+
+ParameterStore::ParameterStore(const HsvThresholds &initial)
+    : values()
+{
+    int snapshot[VALUE_COUNT];
+    toValues(initial.blue, snapshot);
+    toValues(initial.yellow, snapshot + 6);
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        values[i].store(snapshot[i], std::memory_order_relaxed);
+    }
+}
+
+void ParameterStore::Publish(const HsvThresholds &thresholds)
+{
+    int snapshot[VALUE_COUNT];
+    toValues(thresholds.blue, snapshot);
+    toValues(thresholds.yellow, snapshot + 6);
+
+    const uint64_t start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed);
+    // Readers that see any of the new values also see the odd sequence.
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        values[i].store(snapshot[i], std::memory_order_relaxed);
+    }
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+uint64_t ParameterStore::Load(HsvThresholds &thresholds) const
+{
+    int snapshot[VALUE_COUNT];
+    uint64_t before;
+    uint64_t after;
+    do
+    {
+        before = sequence.load(std::memory_order_acquire);
+        for (int i = 0; i < VALUE_COUNT; i++)
+        {
+            snapshot[i] = values[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+
+    thresholds.blue = fromValues(snapshot);
+    thresholds.yellow = fromValues(snapshot + 6);
+    return before / 2;
+}
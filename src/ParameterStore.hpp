@@ -0,0 +1,37 @@
+#ifndef PARAMETER_STORE_HPP
+#define PARAMETER_STORE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include "HsvColorSeparator.hpp"
+
+// Runtime-tunable parameters shared between the debug UI thread (the only writer) and the
+// processing loop. Snapshots are published with a sequence lock: the writer bumps the sequence
+// to odd, stores the values and bumps it to even again; a reader copies the values and retries
+// if the sequence was odd or changed meanwhile. Neither side ever blocks, and the reader can
+// tell from version() alone whether there is anything new.
+class ParameterStore
+{
+public:
+    explicit ParameterStore(const HsvThresholds &initial);
+    ParameterStore(const ParameterStore &) = delete;
+    ParameterStore &operator=(const ParameterStore &) = delete;
+
+    // Writer side; one thread only.
+    void Publish(const HsvThresholds &thresholds);
+
+    // Reader side. Copies the latest complete snapshot and returns its version.
+    uint64_t Load(HsvThresholds &thresholds) const;
+    // Number of snapshots published so far (the initial one is version 0).
+    uint64_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr int VALUE_COUNT = 12;
+
+    std::atomic<uint64_t> sequence{0};
+    // Relaxed atomics so a read overlapping a write is not a data race; the sequence decides
+    // whether the copy is used.
+    std::atomic<int> values[VALUE_COUNT];
+};
+
+#endif // PARAMETER_STORE_HPP
@@ -0,0 +1,48 @@
+#ifndef SEGMENTATION_KERNEL_VARIANTS_HPP
+#define SEGMENTATION_KERNEL_VARIANTS_HPP
+
+// Internal to the SegmentationKernels*.cpp files. The instruction set specific translation
+// units are compiled with extra -m flags, so this header must not pull in OpenCV or anything
+// else with inline code that could end up shared with the rest of the program.
+
+#include <cstdint>
+
+// bounds holds {lowH, lowS, lowV, highH, highS, highV} for blue followed by the same for yellow.
+typedef void (*ThresholdRowFunction)(const uint8_t *hsv, int width, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow);
+// 3x3 cross (the 3x3 elliptical structuring element) over three neighbouring rows. A missing
+// row above or below is passed as the row itself; pixels outside the image are ignored.
+typedef void (*MorphologyRowFunction)(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width);
+
+struct SegmentationKernelVariant
+{
+    const char *name;
+    ThresholdRowFunction thresholdRow;
+    MorphologyRowFunction erodeRow;
+    MorphologyRowFunction dilateRow;
+};
+
+// Scalar reference, also used by the vector versions for the pixels their main loop does not cover.
+void thresholdRowScalar(const uint8_t *hsv, int xBegin, int xEnd, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow);
+void erodeRowScalar(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width, int xBegin, int xEnd);
+void dilateRowScalar(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width, int xBegin, int xEnd);
+
+const SegmentationKernelVariant &scalarKernels();
+#if defined(HAVE_X86_KERNELS)
+const SegmentationKernelVariant &sse41Kernels();
+const SegmentationKernelVariant &avx2Kernels();
+#endif
+#if defined(HAVE_NEON_KERNELS)
+const SegmentationKernelVariant &neonKernels();
+#endif
+
+// The vector variants compiled into this binary, fastest first, and whether this CPU can run
+// them. Returns how many were written to kernels (at most MAX_VECTOR_KERNELS).
+struct CompiledKernelVariant
+{
+    const SegmentationKernelVariant *variant;
+    bool supported;
+};
+constexpr int MAX_VECTOR_KERNELS = 2;
+int compiledVectorKernels(CompiledKernelVariant *kernels);
+
+#endif // SEGMENTATION_KERNEL_VARIANTS_HPP
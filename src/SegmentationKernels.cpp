@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include "SegmentationKernels.hpp"
+
+namespace
+{
+std::atomic<const SegmentationKernelVariant *> selectedVariant{nullptr};
+std::once_flag selectOnce;
+
+uint8_t clampBound(int value)
+{
+    return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+}
+
+// cv::borderInterpolate for BORDER_REFLECT_101, also for images narrower than the kernel.
+int reflect101(int p, int length)
+{
+    if (length == 1)
+    {
+        return 0;
+    }
+    while (p < 0 || p >= length)
+    {
+        p = (p < 0) ? -p : 2 * (length - 1) - p;
+    }
+    return p;
+}
+
+// Small deterministic generator for the self test.
+uint32_t nextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+} // namespace
+
+void SegmentationKernels::Select(std::ostream *report)
+{
+    CompiledKernelVariant compiled[MAX_VECTOR_KERNELS];
+    const int count = compiledVectorKernels(compiled);
+
+    const SegmentationKernelVariant *chosen = &scalarKernels();
+    for (int i = 0; i < count; i++)
+    {
+        if (!compiled[i].supported)
+        {
+            continue;
+        }
+        if (matchesScalar(*compiled[i].variant))
+        {
+            chosen = compiled[i].variant;
+            break;
+        }
+        // A broken kernel is a bug (segmentation-kernels-test fails on it); never keep quiet about it.
+        (report ? *report : std::cerr) << "Segmentation kernels: '" << compiled[i].variant->name
+                                       << "' does not match the scalar reference, not using it." << std::endl;
+    }
+    selectedVariant.store(chosen);
+    if (report)
+    {
+        *report << "Segmentation kernels: using '" << chosen->name << "'." << std::endl;
+    }
+}
+
+const char *SegmentationKernels::activeName()
+{
+    return active().name;
+}
+
+const SegmentationKernelVariant &SegmentationKernels::active()
+{
+    const SegmentationKernelVariant *variant = selectedVariant.load();
+    if (variant == nullptr)
+    {
+        std::call_once(selectOnce, []()
+                       {
+                           if (selectedVariant.load() == nullptr)
+                           {
+                               Select();
+                           }
+                       });
+        variant = selectedVariant.load();
+    }
+    return *variant;
+}
+
+bool SegmentationKernels::matchesScalar(const SegmentationKernelVariant &variant)
+{
+    const SegmentationKernelVariant &reference = scalarKernels();
+    uint32_t state = 0x9e3779b9u;
+
+    // Odd widths exercise the scalar tails, sparse masks the morphology edges.
+    for (int width : {1, 2, 15, 16, 17, 31, 33, 64, 97, 640})
+    {
+        std::vector<uint8_t> hsv(static_cast<size_t>(width) * 3);
+        std::vector<uint8_t> rows(static_cast<size_t>(width) * 3);
+        std::vector<uint8_t> expectedBlue(static_cast<size_t>(width)), expectedYellow(static_cast<size_t>(width));
+        std::vector<uint8_t> actualBlue(static_cast<size_t>(width)), actualYellow(static_cast<size_t>(width));
+
+        for (int round = 0; round < 64; round++)
+        {
+            uint8_t bounds[12];
+            for (int i = 0; i < 12; i++)
+            {
+                bounds[i] = static_cast<uint8_t>(nextRandom(state));
+            }
+            for (auto &value : hsv)
+            {
+                value = static_cast<uint8_t>(nextRandom(state));
+            }
+            for (auto &value : rows)
+            {
+                const uint32_t r = nextRandom(state);
+                value = (round % 2 == 0) ? static_cast<uint8_t>(r) : ((r & 7) == 0 ? 0 : 255);
+            }
+
+            reference.thresholdRow(hsv.data(), width, bounds, expectedBlue.data(), expectedYellow.data());
+            variant.thresholdRow(hsv.data(), width, bounds, actualBlue.data(), actualYellow.data());
+            if (expectedBlue != actualBlue || expectedYellow != actualYellow)
+            {
+                return false;
+            }
+
+            const uint8_t *above = rows.data();
+            const uint8_t *row = above + width;
+            const uint8_t *below = row + width;
+            reference.erodeRow(above, row, below, expectedBlue.data(), width);
+            variant.erodeRow(above, row, below, actualBlue.data(), width);
+            reference.dilateRow(above, row, below, expectedYellow.data(), width);
+            variant.dilateRow(above, row, below, actualYellow.data(), width);
+            if (expectedBlue != actualBlue || expectedYellow != actualYellow)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void SegmentationKernels::Threshold(const cv::Mat &hsv, const HsvThresholds &thresholds, cv::Mat &blueMask, cv::Mat &yellowMask)
+{
+    blueMask.create(hsv.rows, hsv.cols, CV_8UC1);
+    yellowMask.create(hsv.rows, hsv.cols, CV_8UC1);
+
+    const uint8_t bounds[12] = {clampBound(thresholds.blue.lowH), clampBound(thresholds.blue.lowS), clampBound(thresholds.blue.lowV),
+                                clampBound(thresholds.blue.highH), clampBound(thresholds.blue.highS), clampBound(thresholds.blue.highV),
+                                clampBound(thresholds.yellow.lowH), clampBound(thresholds.yellow.lowS), clampBound(thresholds.yellow.lowV),
+                                clampBound(thresholds.yellow.highH), clampBound(thresholds.yellow.highS), clampBound(thresholds.yellow.highV)};
+
+    const ThresholdRowFunction thresholdRow = active().thresholdRow;
+    for (int y = 0; y < hsv.rows; y++)
+    {
+        thresholdRow(hsv.ptr<uchar>(y), hsv.cols, bounds, blueMask.ptr<uchar>(y), yellowMask.ptr<uchar>(y));
+    }
+}
+
+void SegmentationKernels::Erode(const cv::Mat &src, cv::Mat &dst)
+{
+    morphology(src, dst, active().erodeRow);
+}
+
+void SegmentationKernels::Dilate(const cv::Mat &src, cv::Mat &dst)
+{
+    morphology(src, dst, active().dilateRow);
+}
+
+void SegmentationKernels::morphology(const cv::Mat &src, cv::Mat &dst, MorphologyRowFunction rowFunction)
+{
+    CV_Assert(src.type() == CV_8UC1 && src.data != dst.data);
+    dst.create(src.rows, src.cols, CV_8UC1);
+    for (int y = 0; y < src.rows; y++)
+    {
+        const uchar *row = src.ptr<uchar>(y);
+        const uchar *above = (y > 0) ? src.ptr<uchar>(y - 1) : row;
+        const uchar *below = (y + 1 < src.rows) ? src.ptr<uchar>(y + 1) : row;
+        rowFunction(above, row, below, dst.ptr<uchar>(y), src.cols);
+    }
+}
+
+void SegmentationKernels::GaussianBlur5x5(const cv::Mat &src, cv::Mat &dst, std::vector<uint16_t> &sums)
+{
+    CV_Assert(src.type() == CV_8UC1 && src.data != dst.data);
+    dst.create(src.rows, src.cols, CV_8UC1);
+    const int width = src.cols;
+    if (sums.size() < static_cast<size_t>(width))
+    {
+        sums.resize(static_cast<size_t>(width));
+    }
+    // All products are integers, so vertical then horizontal gives OpenCV's fixed-point sum
+    // (at most 255 * 256) exactly, and (sum + 128) >> 8 is its rounding.
+    const auto horizontal = [&sums, width](int x)
+    {
+        return sums[static_cast<size_t>(reflect101(x - 2, width))] + sums[static_cast<size_t>(reflect101(x + 2, width))] +
+               4 * (sums[static_cast<size_t>(reflect101(x - 1, width))] + sums[static_cast<size_t>(reflect101(x + 1, width))]) +
+               6 * sums[static_cast<size_t>(x)];
+    };
+    for (int y = 0; y < src.rows; y++)
+    {
+        const uchar *r0 = src.ptr<uchar>(reflect101(y - 2, src.rows));
+        const uchar *r1 = src.ptr<uchar>(reflect101(y - 1, src.rows));
+        const uchar *r2 = src.ptr<uchar>(y);
+        const uchar *r3 = src.ptr<uchar>(reflect101(y + 1, src.rows));
+        const uchar *r4 = src.ptr<uchar>(reflect101(y + 2, src.rows));
+        for (int x = 0; x < width; x++)
+        {
+            sums[static_cast<size_t>(x)] = static_cast<uint16_t>(r0[x] + r4[x] + 4 * (r1[x] + r3[x]) + 6 * r2[x]);
+        }
+
+        uchar *out = dst.ptr<uchar>(y);
+        const uint16_t *s = sums.data();
+        const int interiorEnd = width - 2;
+        int x = 0;
+        for (; x < std::min(2, width); x++)
+        {
+            out[x] = static_cast<uchar>((horizontal(x) + 128) >> 8);
+        }
+        for (; x < interiorEnd; x++)
+        {
+            out[x] = static_cast<uchar>((s[x - 2] + s[x + 2] + 4 * (s[x - 1] + s[x + 1]) + 6 * s[x] + 128) >> 8);
+        }
+        for (; x < width; x++)
+        {
+            out[x] = static_cast<uchar>((horizontal(x) + 128) >> 8);
+        }
+    }
+}
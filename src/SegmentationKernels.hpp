@@ -0,0 +1,38 @@
+#ifndef SEGMENTATION_KERNELS_HPP
+#define SEGMENTATION_KERNELS_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "HsvColorSeparator.hpp"
+#include "SegmentationKernelVariants.hpp"
+
+// Hand-vectorized versions of the colour threshold (HsvColorSeparator) and binary morphology
+// (NoiseRemover) steps. The variant is picked at runtime from the CPU features (AVX2, SSE4.1
+// or NEON, falling back to scalar code) and checked against the scalar reference on startup.
+class SegmentationKernels
+{
+public:
+    // Selects the fastest supported variant whose output matches the scalar reference.
+    // Called automatically on first use; call it explicitly to get the report.
+    static void Select(std::ostream *report = nullptr);
+    static const char *activeName();
+
+    // Both masks from an HSV image in one pass; same result as two cv::inRange calls.
+    static void Threshold(const cv::Mat &hsv, const HsvThresholds &thresholds, cv::Mat &blueMask, cv::Mat &yellowMask);
+    // Same results as cv::erode / cv::dilate with the 3x3 elliptical structuring element.
+    static void Erode(const cv::Mat &src, cv::Mat &dst);
+    static void Dilate(const cv::Mat &src, cv::Mat &dst);
+    // Same result as cv::GaussianBlur with a 5x5 kernel, sigma 0 and BORDER_REFLECT_101 |
+    // BORDER_ISOLATED on CV_8UC1: [1 4 6 4 1] / 16 in both directions, rounded half up. Unlike
+    // OpenCV it does not allocate row buffers on every call; sums is scratch that only grows.
+    static void GaussianBlur5x5(const cv::Mat &src, cv::Mat &dst, std::vector<uint16_t> &sums);
+
+private:
+    static const SegmentationKernelVariant &active();
+    static bool matchesScalar(const SegmentationKernelVariant &variant);
+    static void morphology(const cv::Mat &src, cv::Mat &dst, MorphologyRowFunction rowFunction);
+};
+
+#endif // SEGMENTATION_KERNELS_HPP
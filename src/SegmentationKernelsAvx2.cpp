@@ -0,0 +1,98 @@
+// Compiled with -mavx2; only called after runtime detection found AVX2.
+#include <immintrin.h>
+#include "SegmentationKernelVariants.hpp"
+
+namespace
+{
+inline __m256i inRange(__m256i value, __m256i low, __m256i high)
+{
+    const __m256i aboveLow = _mm256_cmpeq_epi8(_mm256_max_epu8(value, low), value);
+    const __m256i belowHigh = _mm256_cmpeq_epi8(_mm256_min_epu8(value, high), value);
+    return _mm256_and_si256(aboveLow, belowHigh);
+}
+
+// Splits 16 interleaved HSV pixels into one register per channel (see the SSE4.1 version).
+inline void deinterleave16(const uint8_t *hsv, __m128i &h, __m128i &s, __m128i &v)
+{
+    const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hsv));
+    const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hsv + 16));
+    const __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hsv + 32));
+
+    h = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                                  _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+                     _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    s = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                                  _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+                     _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    v = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                                  _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+                     _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// 32 pixels per iteration: the 3-byte stride does not map onto the 128-bit lanes of vpshufb,
+// so two 16 pixel halves are deinterleaved separately and joined.
+inline void deinterleave32(const uint8_t *hsv, __m256i &h, __m256i &s, __m256i &v)
+{
+    __m128i h0, s0, v0, h1, s1, v1;
+    deinterleave16(hsv, h0, s0, v0);
+    deinterleave16(hsv + 48, h1, s1, v1);
+    h = _mm256_inserti128_si256(_mm256_castsi128_si256(h0), h1, 1);
+    s = _mm256_inserti128_si256(_mm256_castsi128_si256(s0), s1, 1);
+    v = _mm256_inserti128_si256(_mm256_castsi128_si256(v0), v1, 1);
+}
+
+void thresholdRow(const uint8_t *hsv, int width, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow)
+{
+    __m256i limits[12];
+    for (int i = 0; i < 12; i++)
+    {
+        limits[i] = _mm256_set1_epi8(static_cast<char>(bounds[i]));
+    }
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i h, s, v;
+        deinterleave32(hsv + 3 * x, h, s, v);
+        const __m256i blue = _mm256_and_si256(_mm256_and_si256(inRange(h, limits[0], limits[3]), inRange(s, limits[1], limits[4])), inRange(v, limits[2], limits[5]));
+        const __m256i yellow = _mm256_and_si256(_mm256_and_si256(inRange(h, limits[6], limits[9]), inRange(s, limits[7], limits[10])), inRange(v, limits[8], limits[11]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(blueRow + x), blue);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(yellowRow + x), yellow);
+    }
+    thresholdRowScalar(hsv, x, width, bounds, blueRow, yellowRow);
+}
+
+template <bool ERODE>
+void morphologyRow(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width)
+{
+    // x = 0 has no left neighbour and is left to the scalar code together with the tail.
+    int x = 1;
+    for (; x + 33 <= width; x += 32)
+    {
+        const __m256i up = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(above + x));
+        const __m256i down = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(below + x));
+        const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x - 1));
+        const __m256i centre = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x));
+        const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x + 1));
+        const __m256i result = ERODE ? _mm256_min_epu8(_mm256_min_epu8(_mm256_min_epu8(up, down), _mm256_min_epu8(left, right)), centre)
+                                     : _mm256_max_epu8(_mm256_max_epu8(_mm256_max_epu8(up, down), _mm256_max_epu8(left, right)), centre);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), result);
+    }
+    if (ERODE)
+    {
+        erodeRowScalar(above, row, below, dst, width, 0, 1);
+        erodeRowScalar(above, row, below, dst, width, x, width);
+    }
+    else
+    {
+        dilateRowScalar(above, row, below, dst, width, 0, 1);
+        dilateRowScalar(above, row, below, dst, width, x, width);
+    }
+}
+} // namespace
+
+const SegmentationKernelVariant &avx2Kernels()
+{
+    static const SegmentationKernelVariant variant{"avx2", thresholdRow, morphologyRow<true>, morphologyRow<false>};
+    return variant;
+}
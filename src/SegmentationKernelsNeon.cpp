@@ -0,0 +1,68 @@
+// Compiled with NEON enabled (-mfpu=neon on 32-bit ARM, always available on AArch64).
+#include <arm_neon.h>
+#include "SegmentationKernelVariants.hpp"
+
+namespace
+{
+inline uint8x16_t inRange(uint8x16_t value, uint8x16_t low, uint8x16_t high)
+{
+    return vandq_u8(vcgeq_u8(value, low), vcleq_u8(value, high));
+}
+
+void thresholdRow(const uint8_t *hsv, int width, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow)
+{
+    uint8x16_t limits[12];
+    for (int i = 0; i < 12; i++)
+    {
+        limits[i] = vdupq_n_u8(bounds[i]);
+    }
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        // vld3q does the H/S/V deinterleave in the load.
+        const uint8x16x3_t pixels = vld3q_u8(hsv + 3 * x);
+        const uint8x16_t blue = vandq_u8(vandq_u8(inRange(pixels.val[0], limits[0], limits[3]), inRange(pixels.val[1], limits[1], limits[4])),
+                                         inRange(pixels.val[2], limits[2], limits[5]));
+        const uint8x16_t yellow = vandq_u8(vandq_u8(inRange(pixels.val[0], limits[6], limits[9]), inRange(pixels.val[1], limits[7], limits[10])),
+                                           inRange(pixels.val[2], limits[8], limits[11]));
+        vst1q_u8(blueRow + x, blue);
+        vst1q_u8(yellowRow + x, yellow);
+    }
+    thresholdRowScalar(hsv, x, width, bounds, blueRow, yellowRow);
+}
+
+template <bool ERODE>
+void morphologyRow(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width)
+{
+    // x = 0 has no left neighbour and is left to the scalar code together with the tail.
+    int x = 1;
+    for (; x + 17 <= width; x += 16)
+    {
+        const uint8x16_t up = vld1q_u8(above + x);
+        const uint8x16_t down = vld1q_u8(below + x);
+        const uint8x16_t left = vld1q_u8(row + x - 1);
+        const uint8x16_t centre = vld1q_u8(row + x);
+        const uint8x16_t right = vld1q_u8(row + x + 1);
+        const uint8x16_t result = ERODE ? vminq_u8(vminq_u8(vminq_u8(up, down), vminq_u8(left, right)), centre)
+                                        : vmaxq_u8(vmaxq_u8(vmaxq_u8(up, down), vmaxq_u8(left, right)), centre);
+        vst1q_u8(dst + x, result);
+    }
+    if (ERODE)
+    {
+        erodeRowScalar(above, row, below, dst, width, 0, 1);
+        erodeRowScalar(above, row, below, dst, width, x, width);
+    }
+    else
+    {
+        dilateRowScalar(above, row, below, dst, width, 0, 1);
+        dilateRowScalar(above, row, below, dst, width, x, width);
+    }
+}
+} // namespace
+
+const SegmentationKernelVariant &neonKernels()
+{
+    static const SegmentationKernelVariant variant{"neon", thresholdRow, morphologyRow<true>, morphologyRow<false>};
+    return variant;
+}
@@ -0,0 +1,104 @@
+// Scalar reference of the segmentation kernels and the runtime detection of the vector variants.
+// Kept free of OpenCV so the variants can be tested on their own (segmentation-kernels-test).
+#include <algorithm>
+#include "SegmentationKernelVariants.hpp"
+
+#if defined(HAVE_NEON_KERNELS) && defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace
+{
+inline uint8_t inRange(const uint8_t *pixel, const uint8_t *bounds)
+{
+    return (pixel[0] >= bounds[0] && pixel[0] <= bounds[3] && pixel[1] >= bounds[1] && pixel[1] <= bounds[4] &&
+            pixel[2] >= bounds[2] && pixel[2] <= bounds[5])
+               ? 255
+               : 0;
+}
+
+void thresholdRowReference(const uint8_t *hsv, int width, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow)
+{
+    thresholdRowScalar(hsv, 0, width, bounds, blueRow, yellowRow);
+}
+
+void erodeRowReference(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width)
+{
+    erodeRowScalar(above, row, below, dst, width, 0, width);
+}
+
+void dilateRowReference(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width)
+{
+    dilateRowScalar(above, row, below, dst, width, 0, width);
+}
+} // namespace
+
+void thresholdRowScalar(const uint8_t *hsv, int xBegin, int xEnd, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow)
+{
+    for (int x = xBegin; x < xEnd; x++)
+    {
+        const uint8_t *pixel = hsv + 3 * x;
+        blueRow[x] = inRange(pixel, bounds);
+        yellowRow[x] = inRange(pixel, bounds + 6);
+    }
+}
+
+void erodeRowScalar(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width, int xBegin, int xEnd)
+{
+    for (int x = xBegin; x < xEnd; x++)
+    {
+        uint8_t value = std::min(std::min(above[x], below[x]), row[x]);
+        if (x > 0)
+        {
+            value = std::min(value, row[x - 1]);
+        }
+        if (x + 1 < width)
+        {
+            value = std::min(value, row[x + 1]);
+        }
+        dst[x] = value;
+    }
+}
+
+void dilateRowScalar(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width, int xBegin, int xEnd)
+{
+    for (int x = xBegin; x < xEnd; x++)
+    {
+        uint8_t value = std::max(std::max(above[x], below[x]), row[x]);
+        if (x > 0)
+        {
+            value = std::max(value, row[x - 1]);
+        }
+        if (x + 1 < width)
+        {
+            value = std::max(value, row[x + 1]);
+        }
+        dst[x] = value;
+    }
+}
+
+const SegmentationKernelVariant &scalarKernels()
+{
+    static const SegmentationKernelVariant variant{"scalar", thresholdRowReference, erodeRowReference, dilateRowReference};
+    return variant;
+}
+
+
+int compiledVectorKernels(CompiledKernelVariant *kernels)
+{
+    int count = 0;
+#if defined(HAVE_X86_KERNELS)
+    __builtin_cpu_init();
+    kernels[count++] = CompiledKernelVariant{&avx2Kernels(), __builtin_cpu_supports("avx2") != 0};
+    kernels[count++] = CompiledKernelVariant{&sse41Kernels(), __builtin_cpu_supports("sse4.1") != 0};
+#endif
+#if defined(HAVE_NEON_KERNELS)
+#if defined(__arm__)
+    kernels[count++] = CompiledKernelVariant{&neonKernels(), (getauxval(AT_HWCAP) & HWCAP_NEON) != 0};
+#else
+    kernels[count++] = CompiledKernelVariant{&neonKernels(), true};
+#endif
+#endif
+    return count;
+}
@@ -0,0 +1,85 @@
+// Compiled with -msse4.1; only called after runtime detection found SSE4.1.
+#include <smmintrin.h>
+#include "SegmentationKernelVariants.hpp"
+
+namespace
+{
+inline __m128i inRange(__m128i value, __m128i low, __m128i high)
+{
+    const __m128i aboveLow = _mm_cmpeq_epi8(_mm_max_epu8(value, low), value);
+    const __m128i belowHigh = _mm_cmpeq_epi8(_mm_min_epu8(value, high), value);
+    return _mm_and_si128(aboveLow, belowHigh);
+}
+
+// Splits 16 interleaved HSV pixels into one register per channel.
+inline void deinterleave(const uint8_t *hsv, __m128i &h, __m128i &s, __m128i &v)
+{
+    const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hsv));
+    const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hsv + 16));
+    const __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hsv + 32));
+
+    h = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                                  _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+                     _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    s = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                                  _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+                     _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    v = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                                  _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+                     _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+void thresholdRow(const uint8_t *hsv, int width, const uint8_t *bounds, uint8_t *blueRow, uint8_t *yellowRow)
+{
+    const __m128i blueLow[3] = {_mm_set1_epi8(static_cast<char>(bounds[0])), _mm_set1_epi8(static_cast<char>(bounds[1])), _mm_set1_epi8(static_cast<char>(bounds[2]))};
+    const __m128i blueHigh[3] = {_mm_set1_epi8(static_cast<char>(bounds[3])), _mm_set1_epi8(static_cast<char>(bounds[4])), _mm_set1_epi8(static_cast<char>(bounds[5]))};
+    const __m128i yellowLow[3] = {_mm_set1_epi8(static_cast<char>(bounds[6])), _mm_set1_epi8(static_cast<char>(bounds[7])), _mm_set1_epi8(static_cast<char>(bounds[8]))};
+    const __m128i yellowHigh[3] = {_mm_set1_epi8(static_cast<char>(bounds[9])), _mm_set1_epi8(static_cast<char>(bounds[10])), _mm_set1_epi8(static_cast<char>(bounds[11]))};
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i h, s, v;
+        deinterleave(hsv + 3 * x, h, s, v);
+        const __m128i blue = _mm_and_si128(_mm_and_si128(inRange(h, blueLow[0], blueHigh[0]), inRange(s, blueLow[1], blueHigh[1])), inRange(v, blueLow[2], blueHigh[2]));
+        const __m128i yellow = _mm_and_si128(_mm_and_si128(inRange(h, yellowLow[0], yellowHigh[0]), inRange(s, yellowLow[1], yellowHigh[1])), inRange(v, yellowLow[2], yellowHigh[2]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(blueRow + x), blue);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(yellowRow + x), yellow);
+    }
+    thresholdRowScalar(hsv, x, width, bounds, blueRow, yellowRow);
+}
+
+template <bool ERODE>
+void morphologyRow(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst, int width)
+{
+    // x = 0 has no left neighbour and is left to the scalar code together with the tail.
+    int x = 1;
+    for (; x + 17 <= width; x += 16)
+    {
+        const __m128i up = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x));
+        const __m128i down = _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + x));
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x - 1));
+        const __m128i centre = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x + 1));
+        const __m128i result = ERODE ? _mm_min_epu8(_mm_min_epu8(_mm_min_epu8(up, down), _mm_min_epu8(left, right)), centre)
+                                     : _mm_max_epu8(_mm_max_epu8(_mm_max_epu8(up, down), _mm_max_epu8(left, right)), centre);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), result);
+    }
+    if (ERODE)
+    {
+        erodeRowScalar(above, row, below, dst, width, 0, 1);
+        erodeRowScalar(above, row, below, dst, width, x, width);
+    }
+    else
+    {
+        dilateRowScalar(above, row, below, dst, width, 0, 1);
+        dilateRowScalar(above, row, below, dst, width, x, width);
+    }
+}
+} // namespace
+
+const SegmentationKernelVariant &sse41Kernels()
+{
+    static const SegmentationKernelVariant variant{"sse4.1", thresholdRow, morphologyRow<true>, morphologyRow<false>};
+    return variant;
+}
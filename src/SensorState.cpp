@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include "SensorState.hpp"
+
+// The control loop must never wait on a lock hidden in a std::atomic. std::atomic<double> uses the
+// same 8-byte instructions as long long (mov and lock cmpxchg on x86-64, ldxr/stxr on the arm64v8
+// image), so it is lock-free wherever long long is.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "SensorState needs lock-free 64-bit atomics");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "SensorState needs lock-free 32-bit atomics");
+static_assert(sizeof(double) == sizeof(long long) && sizeof(uint64_t) == sizeof(long long),
+              "SensorState assumes 64-bit doubles and sequence numbers");
+
+SensorState::SensorState()
+    : values()
+{
+    for (int i = 0; i < SteeringModel::FEATURE_COUNT; i++)
+    {
+        values[i].store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+    }
+}
+
+void SensorState::PublishAngularVelocity(double x, double y, double z)
+{
+    const double samples[] = {x, y, z};
+    publish(SteeringModel::ANGULAR_VELOCITY_X, samples, 3);
+}
+
+bool SensorState::PublishVoltage(uint32_t senderStamp, double voltage)
+{
+    if (senderStamp != 1 && senderStamp != 3)
+    {
+        return false;
+    }
+    publish(senderStamp == 1 ? SteeringModel::IR_LEFT : SteeringModel::IR_RIGHT, &voltage, 1);
+    return true;
+}
+
+void SensorState::publish(int first, const double *samples, int count)
+{
+    // Claim the lock by moving an even sequence to odd; a concurrent writer waits for the even one.
+    uint64_t start = sequence.load(std::memory_order_relaxed);
+    while ((start & 1) != 0 || !sequence.compare_exchange_weak(start, start + 1, std::memory_order_relaxed))
+    {
+        start = sequence.load(std::memory_order_relaxed);
+    }
+    // Readers that see any of the new values also see the odd sequence.
+    std::atomic_thread_fence(std::memory_order_release);
+    uint32_t mask = received.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++)
+    {
+        values[first + i].store(samples[i], std::memory_order_relaxed);
+        mask |= 1u << (first + i);
+    }
+    received.store(mask, std::memory_order_relaxed);
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+bool SensorState::Load(double *features, int required) const
+{
+    uint64_t before;
+    uint64_t after;
+    uint32_t mask;
+    do
+    {
+        before = sequence.load(std::memory_order_acquire);
+        for (int i = 0; i < SteeringModel::FEATURE_COUNT; i++)
+        {
+            features[i] = values[i].load(std::memory_order_relaxed);
+        }
+        mask = received.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    const uint32_t requiredMask = (1u << std::min(std::max(required, 0), static_cast<int>(SteeringModel::FEATURE_COUNT))) - 1;
+    return (mask & requiredMask) == requiredMask;
+}
@@ -0,0 +1,47 @@
+#ifndef SENSOR_STATE_HPP
+#define SENSOR_STATE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include "SteeringModel.hpp"
+
+// Latest AngularVelocityReading and IR VoltageReading samples, written by the OD4 data triggers
+// and read by the control loop as one SteeringModel feature vector, so the service no longer
+// needs the Python process (service.py) collecting them. Same sequence lock as ParameterStore,
+// except that a writer claims the odd sequence with a compare-and-swap, because the triggers of
+// the two message types are not guaranteed to share a thread. Readers never block and never
+// allocate; a reader that overlaps a write retries with the next copy.
+class SensorState
+{
+public:
+    // All features start as NaN, which SteeringModel replaces by the imputer's statistics; Load
+    // reports them as missing until each one has been published.
+    SensorState();
+    SensorState(const SensorState &) = delete;
+    SensorState &operator=(const SensorState &) = delete;
+
+    // Writer side.
+    void PublishAngularVelocity(double x, double y, double z);
+    // IR voltage by VoltageReading sender stamp (1 left, 3 right). Returns false for other stamps.
+    bool PublishVoltage(uint32_t senderStamp, double voltage);
+
+    // Reader side. Copies a consistent feature vector of SteeringModel::FEATURE_COUNT values and
+    // returns whether the first required features (SteeringModel::featureCount()) have all been
+    // published at least once. Until then the model would predict from imputed values, so the
+    // caller should not use it.
+    bool Load(double *features, int required) const;
+    uint64_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    // Stores count values starting at feature first as one update.
+    void publish(int first, const double *samples, int count);
+
+    std::atomic<uint64_t> sequence{0};
+    // Bit per feature that has been published; written under the sequence like the values.
+    std::atomic<uint32_t> received{0};
+    // Relaxed atomics so a read overlapping a write is not a data race; the sequence decides
+    // whether the copy is used.
+    std::atomic<double> values[SteeringModel::FEATURE_COUNT];
+};
+
+#endif // SENSOR_STATE_HPP
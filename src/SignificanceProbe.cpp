@@ -0,0 +1,141 @@
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
+#include "SignificanceProbe.hpp"
+
+SignificanceProbe::SignificanceProbe()
+    : visited(),
+      stack()
+{
+    stack.reserve(4096);
+}
+
+bool SignificanceProbe::HasBlobLargerThan(const cv::Mat &mask, double minimumArea)
+{
+    CV_Assert(mask.type() == CV_8UC1);
+    probeCount++;
+    totalRows += static_cast<uint64_t>(mask.rows);
+
+    // Every 2x2 window adds at most a quarter of a pixel per set pixel to the contour area, so a
+    // blob's area is bounded by its pixel count and the total count bounds all of them.
+    const int64_t nonzero = cv::countNonZero(mask);
+    nonzeroPixels += static_cast<uint64_t>(nonzero);
+    if (static_cast<double>(nonzero) <= minimumArea)
+    {
+        rejectedByCount++;
+        return false;
+    }
+
+    const size_t pixels = static_cast<size_t>(mask.rows) * static_cast<size_t>(mask.cols);
+    if (visited.size() != pixels || ++stamp == 0)
+    {
+        visited.assign(pixels, 0);
+        stamp = 1;
+    }
+
+    // Twice the area is an integer, so "area > minimumArea" is "twice > floor(2 * minimumArea)".
+    const int64_t twiceLimit = static_cast<int64_t>(std::floor(2.0 * minimumArea));
+    int64_t remaining = nonzero;
+    for (int y = 0; y < mask.rows; y++)
+    {
+        const uchar *row = mask.ptr<uchar>(y);
+        const uint32_t *visitedRow = &visited[static_cast<size_t>(y) * static_cast<size_t>(mask.cols)];
+        for (int x = 0; x < mask.cols; x++)
+        {
+            if (row[x] == 0 || visitedRow[x] == stamp)
+            {
+                continue;
+            }
+            int64_t filled = 0;
+            const bool found = fill(mask, x, y, twiceLimit, filled);
+            filledPixels += static_cast<uint64_t>(filled);
+            remaining -= filled;
+            if (found)
+            {
+                foundEarly++;
+                scannedRows += static_cast<uint64_t>(y + 1);
+                return true;
+            }
+            // Everything before the scan position is visited, so the unvisited pixels form whole
+            // components of their own.
+            if (static_cast<double>(remaining) <= minimumArea)
+            {
+                rejectedByRemainder++;
+                scannedRows += static_cast<uint64_t>(y + 1);
+                return false;
+            }
+        }
+    }
+    scannedRows += static_cast<uint64_t>(mask.rows);
+    return false;
+}
+
+bool SignificanceProbe::fill(const cv::Mat &mask, int x, int y, int64_t twiceLimit, int64_t &filled)
+{
+    const int cols = mask.cols;
+    const int rows = mask.rows;
+    int64_t twiceArea = 0;
+
+    stack.clear();
+    stack.emplace_back(x, y);
+    visited[static_cast<size_t>(y) * static_cast<size_t>(cols) + static_cast<size_t>(x)] = stamp;
+    while (!stack.empty())
+    {
+        const cv::Point p = stack.back();
+        stack.pop_back();
+        filled++;
+
+        // All set pixels of a 2x2 window belong to one 8-connected component. Each window is
+        // counted by its first set pixel in raster order: the window to the lower right when p is
+        // its top-left pixel, and the one to the lower left when p is its top-right pixel and the
+        // top-left one is clear. Windows above p always have an earlier set pixel or at most two.
+        const uchar *row = mask.ptr<uchar>(p.y);
+        const uchar *below = p.y + 1 < rows ? mask.ptr<uchar>(p.y + 1) : nullptr;
+        const bool hasLeft = p.x > 0;
+        const bool hasRight = p.x + 1 < cols;
+        const int right = (hasRight && row[p.x + 1]) ? 1 : 0;
+        const int down = (below && below[p.x]) ? 1 : 0;
+        const int downRight = (below && hasRight && below[p.x + 1]) ? 1 : 0;
+        const int downLeft = (below && hasLeft && below[p.x - 1]) ? 1 : 0;
+        const int corner = right + down + downRight;
+        twiceArea += corner == 3 ? 2 : (corner == 2 ? 1 : 0);
+        if (!(hasLeft && row[p.x - 1]) && down && downLeft)
+        {
+            twiceArea += 1;
+        }
+        if (twiceArea > twiceLimit)
+        {
+            return true;
+        }
+
+        for (int ny = std::max(p.y - 1, 0); ny <= std::min(p.y + 1, rows - 1); ny++)
+        {
+            const uchar *neighbourRow = mask.ptr<uchar>(ny);
+            uint32_t *visitedRow = &visited[static_cast<size_t>(ny) * static_cast<size_t>(cols)];
+            for (int nx = std::max(p.x - 1, 0); nx <= std::min(p.x + 1, cols - 1); nx++)
+            {
+                if (neighbourRow[nx] != 0 && visitedRow[nx] != stamp)
+                {
+                    visitedRow[nx] = stamp;
+                    stack.emplace_back(nx, ny);
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void SignificanceProbe::Print(std::ostream &out) const
+{
+    out << "Significance probe: probes=" << probeCount << " (empty by pixel count=" << rejectedByCount
+        << ", first large blob=" << foundEarly << ", too few pixels left=" << rejectedByRemainder << ")";
+    if (totalRows > 0)
+    {
+        out << " rows scanned=" << 100.0 * static_cast<double>(scannedRows) / static_cast<double>(totalRows) << "%";
+    }
+    if (nonzeroPixels > 0)
+    {
+        out << " foreground filled=" << 100.0 * static_cast<double>(filledPixels) / static_cast<double>(nonzeroPixels) << "%";
+    }
+    out << std::endl;
+}
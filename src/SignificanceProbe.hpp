@@ -0,0 +1,49 @@
+#ifndef SIGNIFICANCE_PROBE_HPP
+#define SIGNIFICANCE_PROBE_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Answers "does this mask contain a blob with a contour area above N?" without labelling the
+// whole mask. The direction check only needs that yes/no, so the probe
+//  - rejects masks with at most N nonzero pixels outright (a blob's contour area never exceeds
+//    its pixel count),
+//  - flood fills one 8-connected component at a time from the first unvisited pixel in raster
+//    order and returns as soon as the area of the component being filled passes N,
+//  - stops once the pixels that are left cannot form a large enough blob.
+// The contour area is measured the same way as BlobExtractor, so the answer matches
+// BlobExtractor::blobs() followed by a contourArea > N check.
+class SignificanceProbe
+{
+public:
+    SignificanceProbe();
+
+    bool HasBlobLargerThan(const cv::Mat &mask, double minimumArea);
+
+    // How much of the masks the probes actually had to look at.
+    void Print(std::ostream &out) const;
+    uint64_t probes() const { return probeCount; }
+
+private:
+    // Fills the component at (x, y). Returns true as soon as twice its contour area exceeds
+    // twiceLimit; filled is increased by the number of pixels reached either way.
+    bool fill(const cv::Mat &mask, int x, int y, int64_t twiceLimit, int64_t &filled);
+
+    // Stamp of the last probe that reached each pixel, so the buffer never has to be cleared.
+    std::vector<uint32_t> visited;
+    uint32_t stamp{0};
+    std::vector<cv::Point> stack;
+
+    uint64_t probeCount{0};
+    uint64_t rejectedByCount{0};     // Decided by the nonzero count alone.
+    uint64_t foundEarly{0};          // Stopped inside the first component larger than the limit.
+    uint64_t rejectedByRemainder{0}; // Stopped because too few unvisited pixels were left.
+    uint64_t scannedRows{0};
+    uint64_t totalRows{0};
+    uint64_t filledPixels{0};
+    uint64_t nonzeroPixels{0};
+};
+
+#endif // SIGNIFICANCE_PROBE_HPP
@@ -0,0 +1,559 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include "SteeringModel.hpp"
+
+namespace
+{
+template <typename T>
+bool readValue(std::istream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+bool readValues(std::istream &in, std::vector<double> &values, uint32_t count)
+{
+    values.resize(count);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(count * sizeof(double))));
+}
+
+// Largest float not above threshold: for every float x, x <= threshold exactly when x <= the result.
+float floatBelow(double threshold)
+{
+    float rounded = static_cast<float>(threshold);
+    if (rounded > threshold)
+    {
+        rounded = std::nextafter(rounded, -std::numeric_limits<float>::infinity());
+    }
+    return rounded;
+}
+} // namespace
+
+constexpr uint8_t SteeringModel::LEAF;
+constexpr int SteeringModel::LANES;
+constexpr int SteeringModel::BLOCK_TREES;
+constexpr int SteeringModel::MAX_BITVECTOR_LEAVES;
+constexpr int SteeringModel::AUTO_BITVECTOR_LEAVES;
+
+SteeringModel::SteeringModel()
+    : mean(),
+      scale(),
+      fill(),
+      feature(),
+      threshold(),
+      thresholdRank(),
+      child(),
+      leafValue(),
+      roots(),
+      featureThresholds(),
+      bitThreshold(),
+      bitTree(),
+      bitMask(),
+      bitOffset(),
+      bitLeafValue(),
+      bitLeafBase()
+{
+}
+
+bool SteeringModel::Load(const std::string &path, std::ostream &log)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        log << "Steering model: cannot open '" << path << "'." << std::endl;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t inputs = 0;
+    uint32_t trees = 0;
+    double newBias = 0.0;
+    double newScale = 0.0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, "D639TREE", sizeof(magic)) != 0 || !readValue(in, version) ||
+        !readValue(in, inputs) || !readValue(in, trees) || !readValue(in, newBias) || !readValue(in, newScale))
+    {
+        log << "Steering model: '" << path << "' is not an exported model." << std::endl;
+        return false;
+    }
+    if (version != FORMAT_VERSION || inputs == 0 || inputs > static_cast<uint32_t>(FEATURE_COUNT) || trees == 0 || trees > MAX_TREES)
+    {
+        log << "Steering model: '" << path << "' has version " << version << ", " << inputs << " features and " << trees
+            << " trees; expected version " << FORMAT_VERSION << ", 1 to " << FEATURE_COUNT << " features and 1 to " << MAX_TREES << " trees." << std::endl;
+        return false;
+    }
+
+    std::vector<double> newMean;
+    std::vector<double> newScales;
+    std::vector<double> newFill;
+    if (!readValues(in, newMean, inputs) || !readValues(in, newScales, inputs) || !readValues(in, newFill, inputs))
+    {
+        log << "Steering model: '" << path << "' ends in the preprocessing parameters." << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<FileNode>> fileTrees(trees);
+    std::vector<bool> reached;
+    size_t total = 0;
+    for (uint32_t t = 0; t < trees; t++)
+    {
+        uint32_t count = 0;
+        if (!readValue(in, count) || count == 0 || total + count > MAX_NODES)
+        {
+            log << "Steering model: tree " << t << " of '" << path << "' is missing or too large." << std::endl;
+            return false;
+        }
+        total += count;
+        std::vector<FileNode> &tree = fileTrees[t];
+        tree.resize(count);
+        reached.assign(count, false);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            FileNode &node = tree[i];
+            if (!readValue(in, node.feature) || !readValue(in, node.threshold) || !readValue(in, node.left) || !readValue(in, node.right) ||
+                !readValue(in, node.value))
+            {
+                log << "Steering model: '" << path << "' ends in tree " << t << "." << std::endl;
+                return false;
+            }
+            // Every node has at most one parent, so the breadth-first copy has the same size.
+            const int64_t index = static_cast<int64_t>(i);
+            if (node.feature >= 0 && (node.feature >= static_cast<int32_t>(inputs) || node.left <= index || node.right <= index ||
+                                      node.left >= static_cast<int64_t>(count) || node.right >= static_cast<int64_t>(count) ||
+                                      node.left == node.right || reached[static_cast<size_t>(node.left)] || reached[static_cast<size_t>(node.right)]))
+            {
+                log << "Steering model: node " << i << " of tree " << t << " in '" << path << "' is malformed." << std::endl;
+                return false;
+            }
+            if (node.feature >= 0)
+            {
+                reached[static_cast<size_t>(node.left)] = true;
+                reached[static_cast<size_t>(node.right)] = true;
+            }
+        }
+    }
+
+    features = static_cast<int>(inputs);
+    bias = newBias;
+    treeScale = newScale;
+    mean.swap(newMean);
+    scale.swap(newScales);
+    fill.swap(newFill);
+    feature.clear();
+    threshold.clear();
+    child.clear();
+    leafValue.clear();
+    roots.clear();
+    for (const std::vector<FileNode> &tree : fileTrees)
+    {
+        addTree(tree);
+    }
+
+    // Distinct thresholds per feature for the quantized layout.
+    featureThresholds.assign(static_cast<size_t>(features), std::vector<float>());
+    for (size_t n = 0; n < feature.size(); n++)
+    {
+        if (feature[n] != LEAF)
+        {
+            featureThresholds[feature[n]].push_back(threshold[n]);
+        }
+    }
+    for (std::vector<float> &values : featureThresholds)
+    {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+    thresholdRank.clear();
+    addBitvectors(fileTrees);
+    currentLayout = (widestTree > 0 && widestTree <= AUTO_BITVECTOR_LEAVES) ? BITVECTORS : FLOAT_THRESHOLDS;
+    return true;
+}
+
+void SteeringModel::addTree(const std::vector<FileNode> &tree)
+{
+    // Position q of the queue becomes node base + q, so the two children of a node, queued
+    // together, end up next to each other.
+    const int32_t base = static_cast<int32_t>(feature.size());
+    roots.push_back(base);
+    std::vector<int32_t> queue(1, 0);
+    for (size_t q = 0; q < queue.size(); q++)
+    {
+        const FileNode &node = tree[static_cast<size_t>(queue[q])];
+        if (node.feature < 0)
+        {
+            feature.push_back(LEAF);
+            threshold.push_back(0.0f);
+            child.push_back(static_cast<int32_t>(leafValue.size()));
+            leafValue.push_back(node.value);
+        }
+        else
+        {
+            feature.push_back(static_cast<uint8_t>(node.feature));
+            threshold.push_back(floatBelow(node.threshold));
+            child.push_back(base + static_cast<int32_t>(queue.size()));
+            queue.push_back(node.left);
+            queue.push_back(node.right);
+        }
+    }
+}
+
+void SteeringModel::addBitvectors(const std::vector<std::vector<FileNode>> &trees)
+{
+    struct Entry
+    {
+        size_t list; // block * features + feature
+        float threshold;
+        uint8_t tree;
+        uint64_t mask;
+    };
+    std::vector<Entry> entries;
+    bitLeafValue.clear();
+    bitLeafBase.clear();
+    widestTree = 0;
+    std::vector<int> leaves;
+    std::vector<int> firstLeaf;
+    for (size_t t = 0; t < trees.size(); t++)
+    {
+        const std::vector<FileNode> &tree = trees[t];
+        // Children have larger indices than their parent, so the leaf counts are complete when
+        // going backwards and the leftmost leaf of every node is known when going forwards.
+        leaves.assign(tree.size(), 1);
+        for (size_t n = tree.size(); n-- > 0;)
+        {
+            if (tree[n].feature >= 0)
+            {
+                leaves[n] = leaves[static_cast<size_t>(tree[n].left)] + leaves[static_cast<size_t>(tree[n].right)];
+            }
+        }
+        if (leaves[0] > MAX_BITVECTOR_LEAVES)
+        {
+            bitThreshold.clear();
+            bitTree.clear();
+            bitMask.clear();
+            bitOffset.clear();
+            bitLeafValue.clear();
+            bitLeafBase.clear();
+            widestTree = 0;
+            return;
+        }
+        widestTree = std::max(widestTree, leaves[0]);
+        // -1 for nodes not reached from the root, which are skipped as in addTree.
+        firstLeaf.assign(tree.size(), -1);
+        firstLeaf[0] = 0;
+        bitLeafBase.push_back(static_cast<uint32_t>(bitLeafValue.size()));
+        bitLeafValue.resize(bitLeafValue.size() + static_cast<size_t>(leaves[0]));
+        for (size_t n = 0; n < tree.size(); n++)
+        {
+            const FileNode &node = tree[n];
+            if (firstLeaf[n] < 0)
+            {
+                continue;
+            }
+            if (node.feature < 0)
+            {
+                bitLeafValue[bitLeafBase.back() + static_cast<size_t>(firstLeaf[n])] = node.value;
+                continue;
+            }
+            const size_t left = static_cast<size_t>(node.left);
+            firstLeaf[left] = firstLeaf[n];
+            firstLeaf[static_cast<size_t>(node.right)] = firstLeaf[n] + leaves[left];
+            const uint64_t leftLeaves = (leaves[left] == 64) ? ~uint64_t{0} : ((uint64_t{1} << leaves[left]) - 1);
+            entries.push_back({(t / BLOCK_TREES) * static_cast<size_t>(features) + static_cast<size_t>(node.feature), floatBelow(node.threshold),
+                               static_cast<uint8_t>(t % BLOCK_TREES), ~(leftLeaves << firstLeaf[n])});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return (a.list != b.list) ? (a.list < b.list) : (a.threshold < b.threshold);
+    });
+    const size_t lists = (trees.size() + BLOCK_TREES - 1) / BLOCK_TREES * static_cast<size_t>(features);
+    bitThreshold.resize(entries.size());
+    bitTree.resize(entries.size());
+    bitMask.resize(entries.size());
+    bitOffset.assign(lists + 1, 0);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        bitThreshold[i] = entries[i].threshold;
+        bitTree[i] = entries[i].tree;
+        bitMask[i] = entries[i].mask;
+        bitOffset[entries[i].list + 1]++;
+    }
+    for (size_t l = 0; l < lists; l++)
+    {
+        bitOffset[l + 1] += bitOffset[l];
+    }
+}
+
+const char *SteeringModel::layoutName(Layout layout)
+{
+    switch (layout)
+    {
+    case THRESHOLD_RANKS:
+        return "16-bit ranks";
+    case BITVECTORS:
+        return "bitvectors";
+    default:
+        return "float thresholds";
+    }
+}
+
+bool SteeringModel::parseLayout(const std::string &name, Layout &layout)
+{
+    if (name == "float")
+    {
+        layout = FLOAT_THRESHOLDS;
+    }
+    else if (name == "ranks")
+    {
+        layout = THRESHOLD_RANKS;
+    }
+    else if (name == "bitvectors")
+    {
+        layout = BITVECTORS;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool SteeringModel::setLayout(Layout layout)
+{
+    if (layout == BITVECTORS && bitOffset.empty())
+    {
+        return false;
+    }
+    if (layout != THRESHOLD_RANKS)
+    {
+        currentLayout = layout;
+        return true;
+    }
+    for (const std::vector<float> &values : featureThresholds)
+    {
+        if (values.size() > std::numeric_limits<uint16_t>::max())
+        {
+            return false;
+        }
+    }
+    thresholdRank.assign(feature.size(), 0);
+    for (size_t n = 0; n < feature.size(); n++)
+    {
+        if (feature[n] != LEAF)
+        {
+            const std::vector<float> &values = featureThresholds[feature[n]];
+            thresholdRank[n] = static_cast<uint16_t>(std::lower_bound(values.begin(), values.end(), threshold[n]) - values.begin());
+        }
+    }
+    currentLayout = THRESHOLD_RANKS;
+    return true;
+}
+
+size_t SteeringModel::modelBytes() const
+{
+    if (currentLayout == BITVECTORS)
+    {
+        return bitThreshold.size() * (sizeof(float) + sizeof(uint8_t) + sizeof(uint64_t)) + bitOffset.size() * sizeof(uint32_t) +
+               bitLeafValue.size() * sizeof(double) + bitLeafBase.size() * sizeof(uint32_t);
+    }
+    const size_t thresholdBytes = (currentLayout == THRESHOLD_RANKS) ? sizeof(uint16_t) : sizeof(float);
+    return feature.size() * (sizeof(uint8_t) + thresholdBytes + sizeof(int32_t)) + leafValue.size() * sizeof(double);
+}
+
+void SteeringModel::prepare(const double *raw, float *input, uint16_t *ranks) const
+{
+    // sklearn compares float32 features against the thresholds, so the scaled values are rounded
+    // the same way.
+    for (int i = 0; i < features; i++)
+    {
+        const size_t f = static_cast<size_t>(i);
+        const double scaled = (raw[i] - mean[f]) / scale[f];
+        input[f] = static_cast<float>(std::isnan(scaled) ? fill[f] : scaled);
+        if (currentLayout == THRESHOLD_RANKS)
+        {
+            // x <= the threshold of rank k exactly when fewer than k + 1 thresholds are below x.
+            const std::vector<float> &values = featureThresholds[f];
+            ranks[f] = static_cast<uint16_t>(std::lower_bound(values.begin(), values.end(), input[f]) - values.begin());
+        }
+    }
+}
+
+template <bool Ranks>
+void SteeringModel::walk(const float *inputs, const uint16_t *ranks, int firstTree, int trees, int vectors, double *sums) const
+{
+    int32_t node[LANES];
+    int offset[LANES]; // Of the lane's vector in inputs / ranks.
+    int lanes = 0;
+    for (int t = 0; t < trees; t++)
+    {
+        for (int v = 0; v < vectors; v++)
+        {
+            node[lanes] = roots[static_cast<size_t>(firstTree + t)];
+            offset[lanes] = v * FEATURE_COUNT;
+            lanes++;
+        }
+    }
+    // The loads of one level are independent of each other, so their cache misses overlap.
+    bool active = true;
+    while (active)
+    {
+        active = false;
+        for (int l = 0; l < lanes; l++)
+        {
+            const size_t n = static_cast<size_t>(node[l]);
+            const uint8_t f = feature[n];
+            if (f != LEAF)
+            {
+                const bool right = Ranks ? (ranks[offset[l] + f] > thresholdRank[n]) : (inputs[offset[l] + f] > threshold[n]);
+                node[l] = child[n] + (right ? 1 : 0);
+                active = true;
+            }
+        }
+    }
+    for (int l = 0; l < lanes; l++)
+    {
+        sums[offset[l] / FEATURE_COUNT] += leafValue[static_cast<size_t>(child[static_cast<size_t>(node[l])])];
+    }
+}
+
+void SteeringModel::accumulate(const float *inputs, const uint16_t *ranks, int firstTree, int trees, int vectors, double *sums) const
+{
+    if (currentLayout == THRESHOLD_RANKS)
+    {
+        walk<true>(inputs, ranks, firstTree, trees, vectors, sums);
+    }
+    else
+    {
+        walk<false>(inputs, ranks, firstTree, trees, vectors, sums);
+    }
+}
+
+double SteeringModel::bitvectorSum(const float *input) const
+{
+    std::array<uint64_t, BLOCK_TREES> reachable{};
+    double sum = 0.0;
+    const int trees = treeCount();
+    for (int first = 0; first < trees; first += BLOCK_TREES)
+    {
+        const int blockTrees = std::min(BLOCK_TREES, trees - first);
+        reachable.fill(~uint64_t{0});
+        const size_t list = static_cast<size_t>(first / BLOCK_TREES) * static_cast<size_t>(features);
+        for (size_t f = 0; f < static_cast<size_t>(features); f++)
+        {
+            const float x = input[f];
+            const size_t end = bitOffset[list + f + 1];
+            for (size_t i = bitOffset[list + f]; i < end && x > bitThreshold[i]; i++)
+            {
+                reachable[bitTree[i]] &= bitMask[i];
+            }
+        }
+        for (int t = 0; t < blockTrees; t++)
+        {
+            // The exit leaf is always reachable, so the mask is never 0.
+            const int leaf = __builtin_ctzll(reachable[static_cast<size_t>(t)]);
+            sum += bitLeafValue[bitLeafBase[static_cast<size_t>(first + t)] + static_cast<size_t>(leaf)];
+        }
+    }
+    return sum;
+}
+
+void SteeringModel::bitvectorSums(const float *inputs, int vectors, double *sums) const
+{
+    // reachable[tree * LANES + lane]: the masks of one tree are contiguous, so the select below
+    // runs over LANES adjacent values and vectorizes.
+    std::array<uint64_t, BLOCK_TREES * LANES> reachable{};
+    std::array<float, LANES> column{};
+    const int trees = treeCount();
+    for (int first = 0; first < trees; first += BLOCK_TREES)
+    {
+        const int blockTrees = std::min(BLOCK_TREES, trees - first);
+        reachable.fill(~uint64_t{0});
+        const size_t list = static_cast<size_t>(first / BLOCK_TREES) * static_cast<size_t>(features);
+        for (size_t f = 0; f < static_cast<size_t>(features); f++)
+        {
+            // Unused lanes are below every threshold and never change.
+            column.fill(-std::numeric_limits<float>::infinity());
+            for (int v = 0; v < vectors; v++)
+            {
+                column[static_cast<size_t>(v)] = inputs[static_cast<size_t>(v * FEATURE_COUNT) + f];
+            }
+            const float highest = *std::max_element(column.begin(), column.end());
+            const size_t end = bitOffset[list + f + 1];
+            for (size_t i = bitOffset[list + f]; i < end && highest > bitThreshold[i]; i++)
+            {
+                const float limit = bitThreshold[i];
+                const uint64_t mask = bitMask[i];
+                uint64_t *lanes = &reachable[static_cast<size_t>(bitTree[i]) * LANES];
+                for (int l = 0; l < LANES; l++)
+                {
+                    lanes[l] &= (column[static_cast<size_t>(l)] > limit) ? mask : ~uint64_t{0};
+                }
+            }
+        }
+        for (int t = 0; t < blockTrees; t++)
+        {
+            const double *values = &bitLeafValue[bitLeafBase[static_cast<size_t>(first + t)]];
+            for (int v = 0; v < vectors; v++)
+            {
+                sums[v] += values[__builtin_ctzll(reachable[static_cast<size_t>(t * LANES + v)])];
+            }
+        }
+    }
+}
+
+double SteeringModel::Predict(const double *raw) const
+{
+    std::array<float, FEATURE_COUNT> input{};
+    std::array<uint16_t, FEATURE_COUNT> ranks{};
+    prepare(raw, input.data(), ranks.data());
+    if (currentLayout == BITVECTORS)
+    {
+        return bias + treeScale * bitvectorSum(input.data());
+    }
+
+    // One vector: the lanes are LANES trees at a time.
+    double sum = 0.0;
+    const int trees = treeCount();
+    for (int t = 0; t < trees; t += LANES)
+    {
+        accumulate(input.data(), ranks.data(), t, std::min(LANES, trees - t), 1, &sum);
+    }
+    return bias + treeScale * sum;
+}
+
+void SteeringModel::PredictBatch(const double *raw, int count, double *predictions) const
+{
+    std::array<float, LANES * FEATURE_COUNT> inputs{};
+    std::array<uint16_t, LANES * FEATURE_COUNT> ranks{};
+    std::array<double, LANES> sums{};
+    const int trees = treeCount();
+    // Blocks of LANES vectors go through one tree after the other, so the upper levels of the
+    // tree are loaded once per block.
+    for (int first = 0; first < count; first += LANES)
+    {
+        const int vectors = std::min(LANES, count - first);
+        for (int v = 0; v < vectors; v++)
+        {
+            prepare(raw + static_cast<size_t>(first + v) * FEATURE_COUNT, inputs.data() + v * FEATURE_COUNT, ranks.data() + v * FEATURE_COUNT);
+        }
+        sums.fill(0.0);
+        if (currentLayout == BITVECTORS)
+        {
+            bitvectorSums(inputs.data(), vectors, sums.data());
+        }
+        else
+        {
+            for (int t = 0; t < trees; t++)
+            {
+                accumulate(inputs.data(), ranks.data(), t, 1, vectors, sums.data());
+            }
+        }
+        for (int v = 0; v < vectors; v++)
+        {
+            predictions[first + v] = bias + treeScale * sums[static_cast<size_t>(v)];
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#ifndef STEERING_MODEL_HPP
+#define STEERING_MODEL_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Native inference for the steering models trained in LRegressionModel, so the steering value is
+// computed inside the frame instead of by the Python service (service.py) over OD4. The model is
+// read from the flat binary file written by LRegressionModel/export_model.py, which holds the
+// StandardScaler and SimpleImputer next to the trees, and Predict applies them in the same order
+// as the service: scale, then replace missing features by the imputer's statistics. The random
+// forests and the gradient boosting model use the same file and differ only in bias and scale.
+//
+// File layout (little endian, as on both the car and the PCs):
+//   char[8]  "D639TREE"
+//   uint32   format version (1)
+//   uint32   number of features N (the first N of Feature, in that order)
+//   uint32   number of trees T
+//   float64  bias, float64 tree scale: the prediction is bias + scale * sum of the tree outputs
+//            (0 and 1 / T for a random forest, the initial prediction and the learning rate
+//            for gradient boosting)
+//   float64  scaler mean[N], scaler scale[N], imputer statistics[N]
+//   T times: uint32 node count, then per node
+//            int32 feature (-1 for a leaf), float64 threshold, int32 left, int32 right, float64 value
+// Child indices are relative to the tree and always larger than the node's own index, as in
+// sklearn, which Load checks so that evaluation always ends in a leaf.
+//
+// In memory the trees are not kept as node graphs. Every tree is laid out breadth-first in
+// parallel arrays (feature, threshold, child), so the levels near the root that every prediction
+// visits share cache lines, and the two children of a node are adjacent: the next node is
+// child + (x > threshold), without a branch on the direction. Leaf values are in an array of
+// their own. The thresholds are rounded down to float, which gives the same decisions for
+// float32 features as sklearn's double thresholds.
+//
+// THRESHOLD_RANKS replaces the thresholds by their 16-bit rank among the distinct thresholds of
+// their feature, and every input feature by the number of thresholds below it, so the nodes are
+// 2 bytes smaller and the decisions stay exact.
+//
+// BITVECTORS is QuickScorer (Lucchese et al., SIGIR 2015) for trees of at most 64 leaves, such as
+// the shallow trees of the boosting model. The leaves of a tree are numbered from left to right
+// and the tree's state is a 64-bit mask of the leaves still reachable. Every internal node holds
+// the mask without the leaves of its left subtree, which are unreachable once x > threshold. The
+// nodes of BLOCK_TREES trees are interleaved per feature in ascending threshold order, so each
+// feature is one scan that ANDs the masks of the nodes until x <= threshold; the exit leaf of a
+// tree is then the lowest bit left. There is no branch on the path through the trees, and in
+// PredictBatch the masks of LANES vectors are updated together with a branch-free select.
+class SteeringModel
+{
+public:
+    // Features in training order (LRegressionModel/IR+AngularApproach/train.py).
+    enum Feature
+    {
+        ANGULAR_VELOCITY_X,
+        ANGULAR_VELOCITY_Y,
+        ANGULAR_VELOCITY_Z,
+        IR_LEFT,  // voltage_x, VoltageReading sender stamp 1
+        IR_RIGHT, // voltage_y, VoltageReading sender stamp 3
+        FEATURE_COUNT
+    };
+
+    enum Layout
+    {
+        FLOAT_THRESHOLDS,
+        THRESHOLD_RANKS,
+        BITVECTORS
+    };
+
+    SteeringModel();
+
+    // Replaces the model with the one in path. On failure the reason is written to log and the
+    // previous model is kept. The layout is BITVECTORS if every tree has at most
+    // AUTO_BITVECTOR_LEAVES leaves, else FLOAT_THRESHOLDS.
+    bool Load(const std::string &path, std::ostream &log);
+    bool loaded() const { return !roots.empty(); }
+
+    // Returns false (and keeps the current layout) if the model does not fit layout: a feature with
+    // more distinct thresholds than 16 bits hold, or a tree with more than 64 leaves.
+    bool setLayout(Layout layout);
+    Layout layout() const { return currentLayout; }
+    static const char *layoutName(Layout layout);
+    // "float", "ranks" or "bitvectors".
+    static bool parseLayout(const std::string &name, Layout &layout);
+
+    // features holds FEATURE_COUNT raw sensor values, NaN for the ones not received yet. Does not
+    // allocate.
+    double Predict(const double *features) const;
+    // Predictions for count feature vectors of FEATURE_COUNT values each, stored one after the
+    // other. Blocks of vectors walk each tree together, so their node loads overlap. Does not
+    // allocate.
+    void PredictBatch(const double *features, int count, double *predictions) const;
+
+    int featureCount() const { return features; }
+    int treeCount() const { return static_cast<int>(roots.size()); }
+    size_t nodeCount() const { return feature.size(); }
+    // Bytes of the node and leaf arrays in the active layout.
+    size_t modelBytes() const;
+
+private:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    // Upper bounds that reject a corrupt header before anything is allocated.
+    static constexpr uint32_t MAX_TREES = 100000;
+    static constexpr uint32_t MAX_NODES = 1u << 24;
+    static constexpr uint8_t LEAF = 0xff;
+    // (vector, tree) pairs walked together.
+    static constexpr int LANES = 16;
+    // Trees whose masks are updated in one pass over the features (BITVECTORS).
+    static constexpr int BLOCK_TREES = 64;
+    static constexpr int MAX_BITVECTOR_LEAVES = 64;
+    // Above this, the scans over the interleaved nodes were slower than the tree walk on a PC
+    // (300 boosted trees: 1.6x faster at depth 3, 1.2x slower at depth 5). The shipped boosting
+    // model (at most 8 leaves) is 1.4x faster than with the walk at p50. Not yet measured on
+    // the arm64v8 board.
+    static constexpr int AUTO_BITVECTOR_LEAVES = 16;
+
+    // Node as stored in the file, with tree-relative children.
+    struct FileNode
+    {
+        int32_t feature;
+        int32_t left;
+        int32_t right;
+        double threshold;
+        double value;
+    };
+
+    // Appends tree in breadth-first order to the node arrays.
+    void addTree(const std::vector<FileNode> &tree);
+    // Builds the BITVECTORS arrays, or leaves them empty if a tree has too many leaves.
+    void addBitvectors(const std::vector<std::vector<FileNode>> &trees);
+    // Scaled and imputed features of one vector, as float and (when quantized) as ranks.
+    void prepare(const double *raw, float *input, uint16_t *ranks) const;
+    // Adds the outputs of trees [firstTree, firstTree + trees) for the first vectors vectors of
+    // inputs / ranks (FEATURE_COUNT values each) to sums. At most LANES (vector, tree) pairs; they
+    // all go down one level before any goes down the next.
+    template <bool Ranks>
+    void walk(const float *inputs, const uint16_t *ranks, int firstTree, int trees, int vectors, double *sums) const;
+    void accumulate(const float *inputs, const uint16_t *ranks, int firstTree, int trees, int vectors, double *sums) const;
+    // Sum of the tree outputs for one vector, and for vectors (at most LANES) vectors, with BITVECTORS.
+    double bitvectorSum(const float *input) const;
+    void bitvectorSums(const float *inputs, int vectors, double *sums) const;
+
+    int features{0};
+    double bias{0.0};
+    double treeScale{0.0};
+    std::vector<double> mean;
+    std::vector<double> scale;
+    std::vector<double> fill;
+    // Node arrays; the children of node n are child[n] and child[n] + 1. For a leaf, child is the
+    // index into leafValue.
+    std::vector<uint8_t> feature;
+    std::vector<float> threshold;
+    std::vector<uint16_t> thresholdRank;
+    std::vector<int32_t> child;
+    std::vector<double> leafValue;
+    std::vector<int32_t> roots; // First node of every tree.
+    // Sorted distinct thresholds of every feature, for the ranks of the inputs.
+    std::vector<std::vector<float>> featureThresholds;
+    // BITVECTORS: the nodes of block b and feature f are [bitOffset[b * features + f],
+    // bitOffset[b * features + f + 1]), sorted by threshold; bitTree is the tree within the block.
+    std::vector<float> bitThreshold;
+    std::vector<uint8_t> bitTree;
+    std::vector<uint64_t> bitMask;
+    std::vector<uint32_t> bitOffset;
+    // Leaf values of tree t from left to right, starting at bitLeafBase[t].
+    std::vector<double> bitLeafValue;
+    std::vector<uint32_t> bitLeafBase;
+    int widestTree{0}; // Leaves of the largest tree, 0 without BITVECTORS.
+    Layout currentLayout{FLOAT_THRESHOLDS};
+};
+
+#endif // STEERING_MODEL_HPP
@@ -0,0 +1,5 @@
+#include "SteeringPolicy.hpp"
+
+// Storage for the zone tables; the lookups index them at runtime.
+constexpr SteeringZone SteeringZones<TrackDirection::Clockwise>::zones[];
+constexpr SteeringZone SteeringZones<TrackDirection::CounterClockwise>::zones[];
@@ -0,0 +1,160 @@
+#ifndef STEERING_POLICY_HPP
+#define STEERING_POLICY_HPP
+
+#include <cstdint>
+
+// The steering decision as data: the image is cut by the left third, centre and right third
+// lines into seven regions (the lines themselves count as regions, since the decision treats a
+// centroid exactly on a line differently from one next to it), and each track direction has a
+// table of zones that maps a (blue region, yellow region) pair to a steering value.
+//
+// The zone tables are checked at compile time to cover every pair exactly once, and are
+// flattened into a 7 x 7 lookup per direction, so deciding is two region computations and one
+// load. A new policy is a new TrackDirection and a new SteeringZones specialization.
+
+enum class TrackDirection
+{
+    Clockwise,       // Blue cones on the left, yellow cones on the right.
+    CounterClockwise // Blue cones on the right, yellow cones on the left.
+};
+
+enum SteeringRegion : uint8_t
+{
+    FAR_LEFT,       // x < left third
+    ON_LEFT_THIRD,  // x == left third
+    LEFT_CENTER,    // left third < x < centre
+    ON_CENTER,      // x == centre
+    RIGHT_CENTER,   // centre < x < right third
+    ON_RIGHT_THIRD, // x == right third
+    FAR_RIGHT,      // x > right third
+    REGION_COUNT
+};
+
+// Set of regions as a bit mask.
+constexpr uint8_t regions(SteeringRegion region) { return static_cast<uint8_t>(1u << region); }
+template <typename... Rest>
+constexpr uint8_t regions(SteeringRegion region, Rest... rest) { return static_cast<uint8_t>(regions(region) | regions(rest...)); }
+constexpr uint8_t ANY_REGION = (1u << REGION_COUNT) - 1;
+
+struct SteeringZone
+{
+    uint8_t blue;   // Regions of the blue centroid.
+    uint8_t yellow; // Regions of the yellow centroid.
+    bool keep;      // Keep the current steering instead of setting steering.
+    float steering;
+    const char *label; // Printed when VERBOSE.
+};
+
+// Region of x given the three vertical lines (left < centre < right). Six compares, no branches.
+inline SteeringRegion steeringRegion(int x, int left, int center, int right)
+{
+    return static_cast<SteeringRegion>((x >= left) + (x > left) + (x >= center) + (x > center) + (x >= right) + (x > right));
+}
+
+template <TrackDirection direction>
+struct SteeringZones;
+
+template <>
+struct SteeringZones<TrackDirection::Clockwise>
+{
+    static constexpr const char *name = "Clockwise Direction";
+    static constexpr SteeringZone zones[] = {
+        {regions(FAR_LEFT), regions(FAR_RIGHT), false, 0.0f, "Driving Straight"},
+        // Blue cones have crossed from the left third towards the center.
+        {regions(LEFT_CENTER, ON_CENTER, RIGHT_CENTER), ANY_REGION, false, -0.11f, "Steering Right"},
+        {regions(FAR_RIGHT), ANY_REGION, false, -0.225f, "Steering Right Sharpest"},
+        // Otherwise the yellow cones decide.
+        {regions(FAR_LEFT, ON_LEFT_THIRD, ON_RIGHT_THIRD), regions(RIGHT_CENTER), false, 0.11f, "Steering Left"},
+        {regions(FAR_LEFT, ON_LEFT_THIRD, ON_RIGHT_THIRD), regions(LEFT_CENTER), false, 0.17f, "Steering Left Sharp"},
+        {regions(ON_LEFT_THIRD, ON_RIGHT_THIRD), regions(ON_CENTER, ON_RIGHT_THIRD, FAR_RIGHT), false, 0.225f, "Steering Left Sharpest"},
+        {regions(FAR_LEFT), regions(ON_CENTER, ON_RIGHT_THIRD), false, 0.225f, "Steering Left Sharpest"},
+        {regions(FAR_LEFT, ON_LEFT_THIRD, ON_RIGHT_THIRD), regions(FAR_LEFT, ON_LEFT_THIRD), true, 0.0f, "No Steering Adjustment"},
+    };
+};
+
+template <>
+struct SteeringZones<TrackDirection::CounterClockwise>
+{
+    static constexpr const char *name = "Counter-Clockwise Direction";
+    static constexpr SteeringZone zones[] = {
+        {regions(FAR_RIGHT), regions(FAR_LEFT), false, 0.0f, "Driving Straight"},
+        // Blue cones on the right.
+        {regions(LEFT_CENTER, ON_CENTER, RIGHT_CENTER), ANY_REGION, false, 0.11f, "Steering Right"},
+        {regions(ON_RIGHT_THIRD), ANY_REGION, false, 0.225f, "Steering Left Sharpest"},
+        {regions(FAR_RIGHT), regions(ON_LEFT_THIRD, LEFT_CENTER, ON_CENTER, RIGHT_CENTER, ON_RIGHT_THIRD, FAR_RIGHT), false, 0.225f, "Steering Left Sharpest"},
+        // Yellow cones on the left.
+        {regions(FAR_LEFT, ON_LEFT_THIRD), regions(LEFT_CENTER), false, -0.11f, "Steering Right"},
+        {regions(FAR_LEFT, ON_LEFT_THIRD), regions(RIGHT_CENTER), false, -0.17f, "Steering Right Sharp"},
+        {regions(FAR_LEFT, ON_LEFT_THIRD), regions(FAR_LEFT, ON_LEFT_THIRD, ON_CENTER, ON_RIGHT_THIRD, FAR_RIGHT), true, 0.0f, "No Steering Adjustment"},
+    };
+};
+
+// Zone index per (blue, yellow) cell, filled in at compile time.
+struct SteeringLookup
+{
+    static constexpr uint8_t UNCOVERED = 0xff;
+    static constexpr uint8_t OVERLAP = 0xfe;
+
+    uint8_t zone[REGION_COUNT * REGION_COUNT];
+
+    constexpr bool contains(uint8_t value) const
+    {
+        for (int cell = 0; cell < REGION_COUNT * REGION_COUNT; cell++)
+        {
+            if (zone[cell] == value)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+template <typename Zones, int zoneCount>
+constexpr SteeringLookup buildSteeringLookup()
+{
+    SteeringLookup table{};
+    for (int cell = 0; cell < REGION_COUNT * REGION_COUNT; cell++)
+    {
+        table.zone[cell] = SteeringLookup::UNCOVERED;
+    }
+    for (int z = 0; z < zoneCount; z++)
+    {
+        for (int blue = 0; blue < REGION_COUNT; blue++)
+        {
+            for (int yellow = 0; yellow < REGION_COUNT; yellow++)
+            {
+                if ((Zones::zones[z].blue & (1u << blue)) != 0 && (Zones::zones[z].yellow & (1u << yellow)) != 0)
+                {
+                    const int cell = blue * REGION_COUNT + yellow;
+                    table.zone[cell] = (table.zone[cell] == SteeringLookup::UNCOVERED) ? static_cast<uint8_t>(z) : SteeringLookup::OVERLAP;
+                }
+            }
+        }
+    }
+    return table;
+}
+
+template <TrackDirection direction>
+class SteeringPolicy
+{
+    using Zones = SteeringZones<direction>;
+    static constexpr int ZONE_COUNT = static_cast<int>(sizeof(Zones::zones) / sizeof(Zones::zones[0]));
+    static_assert(ZONE_COUNT < SteeringLookup::OVERLAP, "too many zones for the lookup table");
+
+public:
+    static constexpr SteeringLookup lookup = buildSteeringLookup<Zones, ZONE_COUNT>();
+    static_assert(!lookup.contains(SteeringLookup::UNCOVERED), "a pair of centroid regions is not covered by any steering zone");
+    static_assert(!lookup.contains(SteeringLookup::OVERLAP), "a pair of centroid regions is covered by more than one steering zone");
+
+    static const SteeringZone &Decide(SteeringRegion blue, SteeringRegion yellow)
+    {
+        return Zones::zones[lookup.zone[blue * REGION_COUNT + yellow]];
+    }
+    static const char *name() { return Zones::name; }
+};
+
+template <TrackDirection direction>
+constexpr SteeringLookup SteeringPolicy<direction>::lookup;
+
+#endif // STEERING_POLICY_HPP
@@ -0,0 +1,215 @@
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "AngleCalculator.hpp"
+#include "CommonDefs.hpp"
+#include "StreamingBenchmark.hpp"
+
+int StreamingBenchmark::Run(int maxThreads, FramePipeline::ColorMode colorMode, std::ostream &out)
+{
+    const cv::Size sizes[] = {cv::Size(640, 480), cv::Size(1280, 960), cv::Size(1920, 1080), cv::Size(2560, 1440)};
+
+    FramePipeline framePipeline;
+    framePipeline.setColorMode(colorMode);
+    bool identical = true;
+    out << "Streaming benchmark: 1 to " << maxThreads << " threads on " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    for (const cv::Size &size : sizes)
+    {
+        const cv::Mat frame = syntheticFrame(size, static_cast<uint64_t>(size.area()));
+        // Same region and crop as the steering path in main.
+        const cv::Rect region(0, size.height / 2, size.width, size.height / 2);
+        const int blobRows = region.height - AngleCalculator::CROP_HEIGHT;
+
+        std::vector<Blob> referenceBlue;
+        std::vector<Blob> referenceYellow;
+        double singleThreadMs = 0.0;
+        double bestSpeedup = 1.0;
+        int bestThreads = 1;
+        for (int threads = 1; threads <= maxThreads; threads++)
+        {
+            framePipeline.setThreads(threads);
+            for (int i = 0; i < WARMUP_FRAMES; i++)
+            {
+                framePipeline.BeginFrame(frame);
+                framePipeline.ProcessStreaming(region, blobRows);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < TIMED_FRAMES; i++)
+            {
+                framePipeline.BeginFrame(frame);
+                framePipeline.ProcessStreaming(region, blobRows);
+            }
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / TIMED_FRAMES;
+
+            bool same = true;
+            if (threads == 1)
+            {
+                referenceBlue = framePipeline.blueBlobs();
+                referenceYellow = framePipeline.yellowBlobs();
+                singleThreadMs = ms;
+            }
+            else
+            {
+                same = sameBlobs(referenceBlue, framePipeline.blueBlobs()) && sameBlobs(referenceYellow, framePipeline.yellowBlobs());
+                identical = identical && same;
+            }
+            if (singleThreadMs / ms > bestSpeedup)
+            {
+                bestSpeedup = singleThreadMs / ms;
+                bestThreads = threads;
+            }
+            out << size.width << "x" << size.height << " threads=" << threads << ": " << ms << " ms/frame, speedup "
+                << singleThreadMs / ms << "x, blobs: " << framePipeline.blueBlobs().size() << " blue, "
+                << framePipeline.yellowBlobs().size() << " yellow" << (same ? "" : " (DIFFERENT FROM 1 THREAD)") << std::endl;
+        }
+        // One line per size to copy into the scaling table; efficiency is speedup / threads.
+        out << size.width << "x" << size.height << " best: " << bestSpeedup << "x with " << bestThreads << " threads, efficiency "
+            << 100.0 * bestSpeedup / bestThreads << "%" << std::endl;
+    }
+
+    // Coarse-to-fine on all threads against the full-resolution pass on the same threads.
+    const int pyramidLevels[] = {2, 4};
+    for (const cv::Size &size : sizes)
+    {
+        const cv::Mat frame = syntheticFrame(size, static_cast<uint64_t>(size.area()));
+        const cv::Rect region(0, size.height / 2, size.width, size.height / 2);
+        const int blobRows = region.height - AngleCalculator::CROP_HEIGHT;
+
+        const double fullMs = timeFrames(framePipeline, frame, region, blobRows, 1);
+        const std::vector<Blob> referenceBlue = framePipeline.blueBlobs();
+        const std::vector<Blob> referenceYellow = framePipeline.yellowBlobs();
+        out << size.width << "x" << size.height << " full resolution: " << fullMs << " ms/frame" << std::endl;
+        for (int level : pyramidLevels)
+        {
+            const double ms = timeFrames(framePipeline, frame, region, blobRows, level);
+            double errorSum = 0.0;
+            double errorMax = 0.0;
+            int matched = 0;
+            const int missed = compareCentroids(referenceBlue, framePipeline.blueBlobs(), errorSum, errorMax, matched) +
+                               compareCentroids(referenceYellow, framePipeline.yellowBlobs(), errorSum, errorMax, matched);
+            out << size.width << "x" << size.height << " coarse 1/" << level << ": " << ms << " ms/frame, speedup " << fullMs / ms
+                << "x, " << framePipeline.coarseCandidates().size() << " windows, cones missed: " << missed << " of " << missed + matched
+                << ", centroid error mean " << (matched > 0 ? errorSum / matched : 0.0) << " px, max " << errorMax << " px" << std::endl;
+        }
+    }
+    return identical ? 0 : 1;
+}
+
+double StreamingBenchmark::timeFrames(FramePipeline &pipeline, const cv::Mat &frame, const cv::Rect &region, int blobRows, int level)
+{
+    for (int i = 0; i < WARMUP_FRAMES; i++)
+    {
+        pipeline.BeginFrame(frame);
+        pipeline.ProcessCoarseToFine(region, blobRows, level);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TIMED_FRAMES; i++)
+    {
+        pipeline.BeginFrame(frame);
+        pipeline.ProcessCoarseToFine(region, blobRows, level);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / TIMED_FRAMES;
+}
+
+int StreamingBenchmark::compareCentroids(const std::vector<Blob> &reference, const std::vector<Blob> &result, double &errorSum, double &errorMax, int &matched)
+{
+    int missed = 0;
+    for (const Blob &cone : reference)
+    {
+        // Only the cones take part in the steering decision.
+        if (cone.contourArea < AngleCalculator::MIN_CONE_AREA || cone.contourArea > AngleCalculator::MAX_CONE_AREA)
+        {
+            continue;
+        }
+        double best = -1.0;
+        for (const Blob &blob : result)
+        {
+            const cv::Point2d centroid = blob.centroid();
+            if (cone.boundingBox.contains(cv::Point(static_cast<int>(centroid.x), static_cast<int>(centroid.y))))
+            {
+                const double distance = cv::norm(centroid - cone.centroid());
+                best = (best < 0.0) ? distance : std::min(best, distance);
+            }
+        }
+        if (best < 0.0)
+        {
+            missed++;
+        }
+        else
+        {
+            matched++;
+            errorSum += best;
+            errorMax = std::max(errorMax, best);
+        }
+    }
+    return missed;
+}
+
+cv::Mat StreamingBenchmark::syntheticFrame(const cv::Size &size, uint64_t seed)
+{
+    cv::RNG rng(seed);
+    // Grey background (60-199) with +-4 of colour noise per channel, which keeps the saturation at
+    // or below 255 * 8 / 56 = 36, under the thresholds' lowS (42), so only the cones and the
+    // speckles are segmented. Independent channels would put a quarter of the
+    // pixels into the blue hue range, and the 5x5 dilation of the noise removal would make the
+    // whole region one blob.
+    cv::Mat grey(size, CV_8UC1);
+    rng.fill(grey, cv::RNG::UNIFORM, 60, 200);
+    cv::Mat frame;
+    cv::cvtColor(grey, frame, cv::COLOR_GRAY2BGRA);
+    cv::Mat jitter(size, CV_16SC4);
+    rng.fill(jitter, cv::RNG::UNIFORM, cv::Scalar(-4, -4, -4, 0), cv::Scalar(5, 5, 5, 1));
+    cv::add(frame, jitter, frame, cv::noArray(), CV_8UC4);
+
+    // Colours in the middle of the current thresholds, converted back to BGR.
+    const HsvThresholds thresholds = colorSeparator.thresholds();
+    cv::Mat hsv(1, 2, CV_8UC3);
+    hsv.at<cv::Vec3b>(0, 0) = cv::Vec3b(static_cast<uchar>((thresholds.blue.lowH + thresholds.blue.highH) / 2),
+                                        static_cast<uchar>((thresholds.blue.lowS + thresholds.blue.highS) / 2),
+                                        static_cast<uchar>((thresholds.blue.lowV + thresholds.blue.highV) / 2));
+    hsv.at<cv::Vec3b>(0, 1) = cv::Vec3b(static_cast<uchar>((thresholds.yellow.lowH + thresholds.yellow.highH) / 2),
+                                        static_cast<uchar>((thresholds.yellow.lowS + thresholds.yellow.highS) / 2),
+                                        static_cast<uchar>((thresholds.yellow.lowV + thresholds.yellow.highV) / 2));
+    cv::Mat bgr;
+    cv::cvtColor(hsv, bgr, CV_HSV2BGR);
+    const cv::Vec3b colors[2] = {bgr.at<cv::Vec3b>(0, 0), bgr.at<cv::Vec3b>(0, 1)};
+
+    // Cones scale with the resolution; some of them are cut by the stripe boundaries.
+    const int coneSize = std::max(8, size.width / 30);
+    for (int i = 0; i < 40; i++)
+    {
+        const cv::Vec3b &color = colors[i % 2];
+        const int x = rng.uniform(0, size.width - coneSize);
+        const int y = rng.uniform(0, size.height - coneSize);
+        const int w = rng.uniform(coneSize / 2, coneSize);
+        const int h = rng.uniform(coneSize / 2, coneSize * 2);
+        cv::rectangle(frame, cv::Rect(x, y, w, std::min(h, size.height - y)), cv::Scalar(color[0], color[1], color[2], 255), cv::FILLED);
+    }
+    // Speckles that the noise removal has to take out.
+    for (int i = 0; i < size.area() / 200; i++)
+    {
+        const cv::Vec3b &color = colors[i % 2];
+        frame.at<cv::Vec4b>(rng.uniform(0, size.height), rng.uniform(0, size.width)) = cv::Vec4b(color[0], color[1], color[2], 255);
+    }
+    return frame;
+}
+
+bool StreamingBenchmark::sameBlobs(const std::vector<Blob> &a, const std::vector<Blob> &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    // The moments are integers and the contour areas multiples of 0.5, so they compare exactly.
+    auto exact = [](double value) { return static_cast<int64_t>(2.0 * value); };
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].area != b[i].area || exact(a[i].contourArea) != exact(b[i].contourArea) || a[i].boundingBox != b[i].boundingBox ||
+            exact(a[i].m10) != exact(b[i].m10) || exact(a[i].m01) != exact(b[i].m01))
+        {
+            return false;
+        }
+    }
+    return true;
+}
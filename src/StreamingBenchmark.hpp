@@ -0,0 +1,36 @@
+#ifndef STREAMING_BENCHMARK_HPP
+#define STREAMING_BENCHMARK_HPP
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "BlobExtractor.hpp"
+#include "FramePipeline.hpp"
+
+// Offline scaling benchmark of FramePipeline::ProcessStreaming: runs a synthetic frame with
+// blue and yellow cones through the steering path with 1 ... maxThreads threads at 640x480 and
+// at larger resolutions, checks that every thread count gives the same blobs as one thread, and
+// prints the best speedup of each size.
+// Then compares FramePipeline::ProcessCoarseToFine at every pyramid level with the full-resolution
+// pass: time per frame, cones missed, and the centroid error of the cones found.
+class StreamingBenchmark
+{
+public:
+    // Returns 0 if the blobs were identical for all thread counts.
+    static int Run(int maxThreads, FramePipeline::ColorMode colorMode, std::ostream &out);
+
+private:
+    static constexpr int WARMUP_FRAMES = 5;
+    static constexpr int TIMED_FRAMES = 50;
+
+    // BGRA frame (as in the shared memory) with noise, cone coloured rectangles and speckles.
+    static cv::Mat syntheticFrame(const cv::Size &size, uint64_t seed);
+    static double timeFrames(FramePipeline &pipeline, const cv::Mat &frame, const cv::Rect &region, int blobRows, int level);
+    // Matches every cone of reference to the nearest blob of result whose centroid lies in the
+    // cone's bounding box; adds the distances to error and returns the number of unmatched cones.
+    static int compareCentroids(const std::vector<Blob> &reference, const std::vector<Blob> &result, double &errorSum, double &errorMax, int &matched);
+    static bool sameBlobs(const std::vector<Blob> &a, const std::vector<Blob> &b);
+};
+
+#endif // STREAMING_BENCHMARK_HPP
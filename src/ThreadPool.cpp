@@ -0,0 +1,74 @@
+#include <algorithm>
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int threads)
+    : mutex(),
+      wake(),
+      done(),
+      workers()
+{
+    for (int i = 1; i < std::max(1, threads); i++)
+    {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Run(int tasks, const std::function<void(int)> &task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    batch = &task;
+    taskCount = tasks;
+    nextTask = 0;
+    unfinished = tasks;
+    generation++;
+    wake.notify_all();
+
+    drain(lock);
+    done.wait(lock, [this] { return unfinished == 0; });
+    batch = nullptr;
+}
+
+void ThreadPool::work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t seen = generation;
+    while (true)
+    {
+        wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+        if (stopping)
+        {
+            return;
+        }
+        seen = generation;
+        drain(lock);
+    }
+}
+
+void ThreadPool::drain(std::unique_lock<std::mutex> &lock)
+{
+    while (batch != nullptr && nextTask < taskCount)
+    {
+        const int index = nextTask++;
+        const std::function<void(int)> &task = *batch;
+        lock.unlock();
+        task(index);
+        lock.lock();
+        if (--unfinished == 0)
+        {
+            done.notify_all();
+        }
+    }
+}
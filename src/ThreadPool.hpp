@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for fork-join work inside one frame. Run hands out task indices
+// to the workers and to the calling thread, and returns when all tasks are done, so a pool of
+// N threads keeps N - 1 threads of its own.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Calls task(0) ... task(tasks - 1), each exactly once, in any order and on any thread.
+    void Run(int tasks, const std::function<void(int)> &task);
+
+    int threads() const { return static_cast<int>(workers.size()) + 1; }
+
+private:
+    void work();
+    // Runs tasks of the current batch until none are left. Called with lock held.
+    void drain(std::unique_lock<std::mutex> &lock);
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)> *batch{nullptr};
+    int taskCount{0};
+    int nextTask{0};
+    int unfinished{0};
+    uint64_t generation{0};
+    bool stopping{false};
+    std::vector<std::thread> workers;
+};
+
+#endif // THREAD_POOL_HPP
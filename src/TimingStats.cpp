@@ -0,0 +1,58 @@
+#include <algorithm>
+#include "TimingStats.hpp"
+
+TimingStats::TimingStats(std::string statsName, size_t windowSize)
+    : name(std::move(statsName)),
+      window()
+{
+    window.reserve(windowSize);
+}
+
+void TimingStats::Add(int64_t microseconds)
+{
+    if (window.size() < window.capacity())
+    {
+        window.push_back(microseconds);
+    }
+    else
+    {
+        window[next] = microseconds;
+        next = (next + 1) % window.size();
+    }
+
+    if (samples == 0 || microseconds < minimum)
+    {
+        minimum = microseconds;
+    }
+    maximum = std::max(maximum, microseconds);
+    total += microseconds;
+    samples++;
+}
+
+void TimingStats::Add(std::chrono::steady_clock::duration duration)
+{
+    Add(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+}
+
+double TimingStats::mean() const
+{
+    return samples > 0 ? static_cast<double>(total) / static_cast<double>(samples) : 0.0;
+}
+
+int64_t TimingStats::percentile(double p) const
+{
+    if (window.empty())
+    {
+        return 0;
+    }
+    std::vector<int64_t> sorted(window);
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size())));
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+    return sorted[index];
+}
+
+void TimingStats::Print(std::ostream &out) const
+{
+    out << name << ": n=" << samples << " min=" << min() << "us mean=" << mean() << "us p50=" << percentile(50.0)
+        << "us p99=" << percentile(99.0) << "us max=" << max() << "us" << std::endl;
+}
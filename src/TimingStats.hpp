@@ -0,0 +1,39 @@
+#ifndef TIMING_STATS_HPP
+#define TIMING_STATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collects durations (in microseconds) and summarizes them. The most recent samples are
+// kept in a fixed-size window so percentiles can be reported without unbounded growth.
+class TimingStats
+{
+public:
+    explicit TimingStats(std::string statsName, size_t windowSize = 1024);
+
+    void Add(int64_t microseconds);
+    void Add(std::chrono::steady_clock::duration duration);
+
+    uint64_t count() const { return samples; }
+    int64_t min() const { return samples > 0 ? minimum : 0; }
+    int64_t max() const { return maximum; }
+    double mean() const;
+    // Percentile (0-100) over the samples in the window.
+    int64_t percentile(double p) const;
+
+    void Print(std::ostream &out) const;
+
+private:
+    std::string name;
+    std::vector<int64_t> window;
+    size_t next{0};
+    uint64_t samples{0};
+    int64_t total{0};
+    int64_t minimum{0};
+    int64_t maximum{0};
+};
+
+#endif // TIMING_STATS_HPP
@@ -0,0 +1,143 @@
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <string>
+#include "VisualizationSink.hpp"
+
+namespace
+{
+std::chrono::steady_clock::duration periodFromRate(double rateHz)
+{
+    if (rateHz <= 0.0)
+    {
+        return std::chrono::steady_clock::duration::zero();
+    }
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rateHz));
+}
+} // namespace
+
+VisualizationSink::VisualizationSink(double rateHz)
+    : period(periodFromRate(rateHz)),
+      mutex(),
+      wake(),
+      canvas(),
+      finished(),
+      shown(),
+      worker()
+{
+}
+
+VisualizationSink::~VisualizationSink()
+{
+    Stop();
+}
+
+void VisualizationSink::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running)
+    {
+        running = true;
+        worker = std::thread(&VisualizationSink::run, this);
+    }
+}
+
+void VisualizationSink::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+void VisualizationSink::Submit(DetectionRecord &record, std::chrono::steady_clock::time_point now)
+{
+    nextDue = now + period;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        submittedRecords++;
+        replacedRecords += hasPending ? 1 : 0;
+        std::swap(pending, record);
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+void VisualizationSink::Show()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!hasFinished)
+        {
+            return;
+        }
+        std::swap(finished, shown);
+        hasFinished = false;
+    }
+    cv::imshow("Visual Output", shown);
+}
+
+void VisualizationSink::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this] { return hasPending || !running; });
+        if (!running)
+        {
+            return;
+        }
+        std::swap(pending, working);
+        hasPending = false;
+
+        lock.unlock();
+        render(working, canvas);
+        lock.lock();
+
+        std::swap(canvas, finished);
+        hasFinished = true;
+        renderedRecords++;
+    }
+}
+
+void VisualizationSink::render(const DetectionRecord &record, cv::Mat &image)
+{
+    image.create(record.imageSize, CV_8UC3);
+    image.setTo(cv::Scalar(0, 0, 0));
+
+    for (const cv::Rect &box : record.blueBoxes)
+    {
+        cv::rectangle(image, box, cv::Scalar(255, 0, 0), 1);
+    }
+    for (const cv::Rect &box : record.yellowBoxes)
+    {
+        cv::rectangle(image, box, cv::Scalar(0, 255, 255), 1);
+    }
+
+    // Draw image center
+    cv::circle(image, record.imageCenter, 5, cv::Scalar(0, 255, 0), -1); // Green color
+
+    // Draw centroids
+    cv::circle(image, record.blueCentroid, 5, cv::Scalar(255, 0, 0), -1);     // Blue color for blue centroid
+    cv::circle(image, record.yellowCentroid, 5, cv::Scalar(0, 255, 255), -1); // Yellow color for yellow centroid
+
+    // Draw lines from image center to centroids
+    cv::line(image, record.imageCenter, record.blueCentroid, cv::Scalar(255, 0, 0), 2);     // Blue line to blue centroid
+    cv::line(image, record.imageCenter, record.yellowCentroid, cv::Scalar(0, 255, 255), 2); // Yellow line to yellow centroid
+
+    // Drawing the division lines on the image for visual verification
+    cv::line(image, cv::Point(record.leftThirdX, 0), cv::Point(record.leftThirdX, image.rows), cv::Scalar(0, 255, 0), 2);   // Green line for left third
+    cv::line(image, cv::Point(record.rightThirdX, 0), cv::Point(record.rightThirdX, image.rows), cv::Scalar(0, 255, 0), 2); // Green line for right third
+
+    cv::putText(image, "steering " + std::to_string(record.steering), cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+}
+
+void VisualizationSink::Print(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "Visualization: submitted=" << submittedRecords << " rendered=" << renderedRecords << " replaced by newer=" << replacedRecords << std::endl;
+}
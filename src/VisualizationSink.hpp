@@ -0,0 +1,78 @@
+#ifndef VISUALIZATION_SINK_HPP
+#define VISUALIZATION_SINK_HPP
+
+#include <opencv2/core.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// What the steering path found in one frame, in the coordinates of the processed region.
+// Only numbers, so handing it over costs no drawing and no image copies.
+struct DetectionRecord
+{
+    cv::Size imageSize{};
+    cv::Point imageCenter{};
+    cv::Point blueCentroid{};
+    cv::Point yellowCentroid{};
+    int leftThirdX{0};
+    int rightThirdX{0};
+    std::vector<cv::Rect> blueBoxes{};   // Blobs that passed the steering filters.
+    std::vector<cv::Rect> yellowBoxes{};
+    float steering{0.0f};
+};
+
+// Renders the debug view of the steering path on a thread of its own. The producer asks Due()
+// before filling a record, so at most rateHz records per second are built, and a record that
+// was not picked up yet is replaced by the next one (latest wins). The window is shown from
+// the thread that calls Show(), as HighGUI wants all window calls on one thread.
+class VisualizationSink
+{
+public:
+    // rateHz <= 0 renders every submitted record.
+    explicit VisualizationSink(double rateHz);
+    ~VisualizationSink();
+    VisualizationSink(const VisualizationSink &) = delete;
+    VisualizationSink &operator=(const VisualizationSink &) = delete;
+
+    void Start();
+    void Stop();
+
+    // Producer side.
+    bool Due(std::chrono::steady_clock::time_point now) const { return now >= nextDue; }
+    // Takes the contents of record (swapped, so its storage is reused by the next frame).
+    void Submit(DetectionRecord &record, std::chrono::steady_clock::time_point now);
+
+    // Shows the last rendered image if a new one is ready.
+    void Show();
+
+    void Print(std::ostream &out) const;
+
+private:
+    void run();
+    static void render(const DetectionRecord &record, cv::Mat &image);
+
+    const std::chrono::steady_clock::duration period;
+    std::chrono::steady_clock::time_point nextDue{};
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    DetectionRecord pending{};
+    DetectionRecord working{};
+    bool hasPending{false};
+    cv::Mat canvas;
+    cv::Mat finished;
+    bool hasFinished{false};
+    cv::Mat shown;
+
+    uint64_t submittedRecords{0};
+    uint64_t replacedRecords{0};
+    uint64_t renderedRecords{0};
+    bool running{false};
+    std::thread worker;
+};
+
+#endif // VISUALIZATION_SINK_HPP
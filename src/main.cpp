@@ -25,12 +25,29 @@
 // Include the GUI and image processing header files from OpenCV
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
 #include <iostream>
+#include <thread>
 #include "HsvColorSeparator.hpp"
 #include "NoiseRemover.hpp"
+#include "SegmentationKernels.hpp"
 #include "ContourFinder.hpp"
 #include "DirectionCalculator.hpp"
+#include "DirectionEstimator.hpp"
 #include "AngleCalculator.hpp"
+#include "FrameIngestor.hpp"
+#include "FrameRing.hpp"
+#include "FrameAcquisition.hpp"
+#include "FrameScheduler.hpp"
+#include "FramePipeline.hpp"
+#include "ConeTracker.hpp"
+#include "StreamingBenchmark.hpp"
+#include "SteeringModel.hpp"
+#include "ModelBenchmark.hpp"
+#include "SensorState.hpp"
+#include "VisualizationSink.hpp"
+#include "DebugUi.hpp"
+#include "TimingStats.hpp"
 #include "CommonDefs.hpp"
 
 int32_t main(int32_t argc, char **argv)
@@ -63,18 +80,81 @@ int32_t main(int32_t argc, char **argv)
 
     // Parse the command line parameters as we require the user to specify some mandatory information on startup.
     auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
-    if ((0 == commandlineArguments.count("cid")) ||
+    if (0 != commandlineArguments.count("benchmark"))
+    {
+        // Offline: no shared memory or OD4 session needed.
+        FramePipeline::ColorMode colorMode{FramePipeline::ColorMode::Fused};
+        if ((0 != commandlineArguments.count("color")) && !FramePipeline::parseColorMode(commandlineArguments["color"], colorMode))
+        {
+            std::cerr << argv[0] << ": Unknown colour mode '" << commandlineArguments["color"] << "', using 'fused'." << std::endl;
+        }
+        SegmentationKernels::Select(&std::clog);
+        const int THREADS{(0 != commandlineArguments.count("threads")) ? std::max(1, std::stoi(commandlineArguments["threads"]))
+                                                                        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+        retCode = StreamingBenchmark::Run(THREADS, colorMode, std::cout);
+    }
+    else if (0 != commandlineArguments.count("model-benchmark"))
+    {
+        // Offline as well: needs the exported model and the rows written by benchmark_model.py.
+        retCode = ModelBenchmark::Run(commandlineArguments["model"], commandlineArguments["model-benchmark"], std::cout);
+    }
+    else if ((0 == commandlineArguments.count("cid")) ||
         (0 == commandlineArguments.count("name")) ||
         (0 == commandlineArguments.count("width")) ||
         (0 == commandlineArguments.count("height")))
     {
         std::cerr << argv[0] << " attaches to a shared memory area containing an ARGB image." << std::endl;
-        std::cerr << "Usage:   " << argv[0] << " --cid=<OD4 session> --name=<name of shared memory area> [--verbose]" << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " --cid=<OD4 session> --name=<name of shared memory area> [--ingest=<clone|roi|zerocopy>] [--acquisition-thread] [--schedule=<none|latest|nth|degrade>] [--fps=<camera rate>] [--color=<fused|lut|simd>] [--denoise=<filter|binary|classes>] [--streaming] [--threads=<n>] [--track] [--full-search=<frames>] [--coarse=<2|4>] [--direction=<detections|periodic>] [--model=<file>] [--model-layout=<float|ranks|bitvectors>] [--verify] [--verbose] [--viz-rate=<Hz>]" << std::endl;
         std::cerr << "         --cid:    CID of the OD4Session to send and receive messages" << std::endl;
         std::cerr << "         --name:   name of the shared memory area to attach" << std::endl;
         std::cerr << "         --width:  width of the frame" << std::endl;
         std::cerr << "         --height: height of the frame" << std::endl;
+        std::cerr << "         --ingest: how frames leave the shared memory (default: roi)" << std::endl;
+        std::cerr << "                   clone:    copy the full frame" << std::endl;
+        std::cerr << "                   roi:      copy only the rows the pipeline reads" << std::endl;
+        std::cerr << "                   zerocopy: process the shared memory buffer in place" << std::endl;
+        std::cerr << "         --acquisition-thread: wait for and copy frames on a separate thread; the" << std::endl;
+        std::cerr << "                   processing loop always picks up the newest frame" << std::endl;
+        std::cerr << "         --schedule: what to do when processing cannot keep up with the camera (default: none)" << std::endl;
+        std::cerr << "                   latest:  skip frames that are older than one camera period" << std::endl;
+        std::cerr << "                   nth:     process every Nth frame, N follows the processing cost" << std::endl;
+        std::cerr << "                   degrade: process every frame at reduced resolution while over budget" << std::endl;
+        std::cerr << "         --fps:    expected camera frame rate used until it is measured (default: 30)" << std::endl;
+        std::cerr << "         --color:  colour separation method (default: fused)" << std::endl;
+        std::cerr << "                   fused: convert each pixel to HSV and threshold it in one pass" << std::endl;
+        std::cerr << "                   lut:   look each pixel up in a precomputed 4 MB colour class table" << std::endl;
+        std::cerr << "                   simd:  convert with cvtColor, threshold both colours with SSE4.1/AVX2/NEON" << std::endl;
+        std::cerr << "         --denoise: noise removal engine (default: filter)" << std::endl;
+        std::cerr << "                   filter: GaussianBlur, erode and dilate on 8-bit masks" << std::endl;
+        std::cerr << "                   binary: the same on bit-packed masks, 64 pixels per operation" << std::endl;
+        std::cerr << "                   classes: denoise blue and yellow together as one class-bit mask" << std::endl;
+        std::cerr << "         --streaming: classify, denoise and extract blobs row by row for the steering path instead" << std::endl;
+        std::cerr << "                   of writing full masks; uses the classes engine, ignored at reduced resolution" << std::endl;
+        std::cerr << "         --threads: threads for --streaming; the rows are split into stripes (default: 1)" << std::endl;
+        std::cerr << "         --track:  with --streaming, follow the cones from frame to frame and only segment the windows" << std::endl;
+        std::cerr << "                   around their predicted positions; the whole region is searched on a lost track" << std::endl;
+        std::cerr << "         --full-search: with --track, search the whole region every this many frames for new cones (default: 10)" << std::endl;
+        std::cerr << "         --coarse: with --streaming, find the cones on a copy downscaled by this factor and only stream the" << std::endl;
+        std::cerr << "                   windows around them at full resolution; with --track, used for the full searches" << std::endl;
+        std::cerr << "         --direction: how the track direction is found (default: periodic)" << std::endl;
+        std::cerr << "                   detections: from the cones of the steering path on every frame, with hysteresis;" << std::endl;
+        std::cerr << "                               prints the frames until the direction settled on exit" << std::endl;
+        std::cerr << "                   periodic:   extra pass over the upper frame on frames 1-9 and every 15th frame" << std::endl;
+        std::cerr << "         --model:  counter-clockwise steering from this model (LRegressionModel/export_model.py), evaluated" << std::endl;
+        std::cerr << "                   in the loop on the latest AngularVelocityReading / VoltageReading instead of the Python service" << std::endl;
+        std::cerr << "         --model-layout: how the model is evaluated (default: bitvectors if the trees have at most 16 leaves, else float)" << std::endl;
+        std::cerr << "                   float:      tree walk with float thresholds" << std::endl;
+        std::cerr << "                   ranks:      tree walk with 16-bit threshold ranks" << std::endl;
+        std::cerr << "                   bitvectors: QuickScorer leaf masks, for shallow trees such as gradient boosting" << std::endl;
+        std::cerr << "         --verify: cross-check the optimized image processing against the reference OpenCV path (slow)" << std::endl;
+        std::cerr << "         --viz-rate: how often the --verbose debug view is drawn, on its own thread (default: 10, 0: every frame)" << std::endl;
         std::cerr << "Example: " << argv[0] << " --cid=253 --name=img --width=640 --height=480 --verbose" << std::endl;
+        std::cerr << "Benchmark: " << argv[0] << " --benchmark [--threads=<max threads>] [--color=<fused|lut|simd>]" << std::endl;
+        std::cerr << "         runs the streaming path on synthetic frames with 1 to max threads (default: all cores)" << std::endl;
+        std::cerr << "         at 640x480 and larger resolutions and checks that the blobs do not change, then compares" << std::endl;
+        std::cerr << "         the coarse-to-fine levels with the full-resolution pass (speed, missed cones, centroid error)" << std::endl;
+        std::cerr << "Model benchmark: " << argv[0] << " --model-benchmark=<csv> --model=<file>" << std::endl;
+        std::cerr << "         checks and times the native steering model on the rows of LRegressionModel/benchmark_model.py" << std::endl;
     }
     else
     {
@@ -83,12 +163,57 @@ int32_t main(int32_t argc, char **argv)
         const uint32_t WIDTH{static_cast<uint32_t>(std::stoi(commandlineArguments["width"]))};
         const uint32_t HEIGHT{static_cast<uint32_t>(std::stoi(commandlineArguments["height"]))};
         const bool VERBOSE{commandlineArguments.count("verbose") != 0};
+        const bool VERIFY{commandlineArguments.count("verify") != 0};
+        const double VIZ_RATE{(0 != commandlineArguments.count("viz-rate")) ? std::stod(commandlineArguments["viz-rate"]) : 10.0};
+        const bool STREAMING{commandlineArguments.count("streaming") != 0};
+        const int THREADS{(0 != commandlineArguments.count("threads")) ? std::max(1, std::stoi(commandlineArguments["threads"])) : 1};
+        const bool TRACKING{commandlineArguments.count("track") != 0};
+        const int FULL_SEARCH_INTERVAL{(0 != commandlineArguments.count("full-search")) ? std::max(1, std::stoi(commandlineArguments["full-search"])) : 10};
+        // Periodic until the detection-based estimator has been checked on the recordings.
+        const bool PERIODIC_DIRECTION{(0 == commandlineArguments.count("direction")) || (commandlineArguments["direction"] != "detections")};
+        const std::string MODEL{(0 != commandlineArguments.count("model")) ? commandlineArguments["model"] : ""};
+        const int COARSE_LEVEL{(0 != commandlineArguments.count("coarse")) ? std::max(1, std::stoi(commandlineArguments["coarse"])) : 1};
+        FramePipeline::ColorMode colorMode{FramePipeline::ColorMode::Fused};
+        if ((0 != commandlineArguments.count("color")) && !FramePipeline::parseColorMode(commandlineArguments["color"], colorMode))
+        {
+            std::cerr << argv[0] << ": Unknown colour mode '" << commandlineArguments["color"] << "', using 'fused'." << std::endl;
+        }
+        NoiseRemover::Engine noiseEngine{NoiseRemover::Engine::Filter};
+        if ((0 != commandlineArguments.count("denoise")) && !NoiseRemover::parseEngine(commandlineArguments["denoise"], noiseEngine))
+        {
+            std::cerr << argv[0] << ": Unknown noise removal engine '" << commandlineArguments["denoise"] << "', using 'filter'." << std::endl;
+        }
+        noiseRemover.setEngine(noiseEngine);
+
+        FrameIngestor::Mode ingestMode{FrameIngestor::Mode::RoiCopy};
+        if ((0 != commandlineArguments.count("ingest")) && !FrameIngestor::parseMode(commandlineArguments["ingest"], ingestMode))
+        {
+            std::cerr << argv[0] << ": Unknown ingest mode '" << commandlineArguments["ingest"] << "', using 'roi'." << std::endl;
+        }
+        const bool ACQUISITION_THREAD{commandlineArguments.count("acquisition-thread") != 0};
+        if (ACQUISITION_THREAD && ingestMode == FrameIngestor::Mode::ZeroCopy)
+        {
+            // The acquisition thread releases the lock before the frame is processed, so it has to copy.
+            std::cerr << argv[0] << ": Zero-copy ingestion cannot be combined with --acquisition-thread, using 'roi'." << std::endl;
+            ingestMode = FrameIngestor::Mode::RoiCopy;
+        }
+        FrameIngestor frameIngestor(ingestMode, WIDTH, HEIGHT);
+        FrameScheduler::Policy schedulePolicy{FrameScheduler::Policy::None};
+        if ((0 != commandlineArguments.count("schedule")) && !FrameScheduler::parsePolicy(commandlineArguments["schedule"], schedulePolicy))
+        {
+            std::cerr << argv[0] << ": Unknown schedule '" << commandlineArguments["schedule"] << "', using 'none'." << std::endl;
+        }
+        const int FPS{(0 != commandlineArguments.count("fps")) ? std::max(1, std::stoi(commandlineArguments["fps"])) : 30};
+        FrameScheduler frameScheduler(schedulePolicy, 1000000 / FPS);
+        // How long the producer is locked out of the shared memory per frame.
+        TimingStats lockHoldStats("Shared memory lock hold time");
 
         // Attach to the shared memory.
         std::unique_ptr<cluon::SharedMemory> sharedMemory{new cluon::SharedMemory{NAME}};
         if (sharedMemory && sharedMemory->valid())
         {
             std::clog << argv[0] << ": Attached to shared memory '" << sharedMemory->name() << " (" << sharedMemory->size() << " bytes)." << std::endl;
+            std::clog << argv[0] << ": Ingest mode '" << FrameIngestor::modeName(frameIngestor.mode()) << "'." << std::endl;
 
             // Interface to a running OpenDaVINCI session where network messages are exchanged.
             // The instance od4 alblueLowS you to send and receive messages.
@@ -117,12 +242,79 @@ int32_t main(int32_t argc, char **argv)
 
             od4.dataTrigger(SteeringCommand::ID(), onPythonMessage);
 
+            // With --model the counter-clockwise steering is computed here, from the latest sensor samples.
+            SteeringModel steeringModel;
+            if (!MODEL.empty() && steeringModel.Load(MODEL, std::cerr))
+            {
+                SteeringModel::Layout modelLayout{steeringModel.layout()};
+                if ((0 != commandlineArguments.count("model-layout")) && !SteeringModel::parseLayout(commandlineArguments["model-layout"], modelLayout))
+                {
+                    std::cerr << argv[0] << ": Unknown model layout '" << commandlineArguments["model-layout"] << "', using '"
+                              << SteeringModel::layoutName(steeringModel.layout()) << "'." << std::endl;
+                }
+                else if (!steeringModel.setLayout(modelLayout))
+                {
+                    std::cerr << argv[0] << ": The steering model does not fit " << SteeringModel::layoutName(modelLayout) << ", using "
+                              << SteeringModel::layoutName(steeringModel.layout()) << "." << std::endl;
+                }
+                std::clog << argv[0] << ": Steering model '" << MODEL << "' with " << steeringModel.treeCount() << " trees, "
+                          << steeringModel.nodeCount() << " nodes and " << steeringModel.featureCount() << " features, "
+                          << SteeringModel::layoutName(steeringModel.layout()) << " (" << steeringModel.modelBytes() << " bytes)." << std::endl;
+            }
+            else if (!MODEL.empty())
+            {
+                std::cerr << argv[0] << ": Using the steering commands of the Python service." << std::endl;
+            }
+            // Latest sensor samples for the model; the triggers write, the loop reads without locking.
+            SensorState sensorState;
+            if (steeringModel.loaded())
+            {
+                auto onAngularVelocityReading = [&sensorState](cluon::data::Envelope &&env)
+                {
+                    const auto reading = cluon::extractMessage<opendlv::proxy::AngularVelocityReading>(std::move(env));
+                    sensorState.PublishAngularVelocity(reading.angularVelocityX(), reading.angularVelocityY(), reading.angularVelocityZ());
+                };
+                od4.dataTrigger(opendlv::proxy::AngularVelocityReading::ID(), onAngularVelocityReading);
+                // The IR sensors are told apart by the sender stamp: 1 is the left one, 3 the right one.
+                auto onVoltageReading = [&sensorState](cluon::data::Envelope &&env)
+                {
+                    const uint32_t senderStamp = env.senderStamp();
+                    const auto reading = cluon::extractMessage<opendlv::proxy::VoltageReading>(std::move(env));
+                    sensorState.PublishVoltage(senderStamp, reading.voltage());
+                };
+                od4.dataTrigger(opendlv::proxy::VoltageReading::ID(), onVoltageReading);
+            }
+            TimingStats modelTiming("Steering model inference");
+
             // cv::namedWindow("Combined Color tracking", cv::WINDOW_AUTOSIZE);
             // cv::createTrackbar("maxContourArea", "Combined Color tracking", &maxContourArea, 2500);
             // cv::createTrackbar("minContourArea", "Combined Color tracking", &minContourArea, 2500);
 
             DirectionCalculator directionCalculator;
+            // Track direction from the cones of the steering path; replaces directionCalculator with --direction=detections.
+            DirectionEstimator directionEstimator;
             AngleCalculator angleCalculator;
+            // Only the debug view draws, and only when VERBOSE; the steering path just hands over the numbers.
+            VisualizationSink visualizationSink(VIZ_RATE);
+            // The trackbars and the debug view live on the UI thread; the loop below only picks up
+            // new thresholds in BeginFrame.
+            DebugUi debugUi(parameterStore, &visualizationSink);
+            if (VERBOSE)
+            {
+                visualizationSink.Start();
+                angleCalculator.setVisualizationSink(&visualizationSink);
+                debugUi.Start();
+            }
+            // Buffers for the per-frame image processing, reused across frames.
+            FramePipeline framePipeline;
+            framePipeline.setVerify(VERIFY);
+            // Pick the SIMD kernels up front so the CPU check and self test do not land on the first frame.
+            SegmentationKernels::Select(&std::clog);
+            framePipeline.setColorMode(colorMode);
+            framePipeline.setThreads(THREADS);
+            // Cones of the streaming path, followed from frame to frame with --track.
+            ConeTracker coneTracker(FULL_SEARCH_INTERVAL);
+            coneTracker.setCoarseLevel(COARSE_LEVEL);
 
             // Car position on the X axis
             // const int carPositionX = 320;
@@ -131,85 +323,180 @@ int32_t main(int32_t argc, char **argv)
             const float minSteering = -0.3f;
             int frameCount = 0;
 
-            // Endless loop; end the program by pressing Ctrl-C.
-            while (od4.isRunning())
+            // The periodic direction check reads the upper part of the frame, everything else only the bottom half.
+            auto isDirectionFrame = [PERIODIC_DIRECTION](int frameNumber)
             {
+                return PERIODIC_DIRECTION && (frameNumber % 15 == 0 || frameNumber < 10);
+            };
+
+            // Optionally move waiting for and copying frames to a thread of its own.
+            std::unique_ptr<FrameRing> frameRing;
+            std::unique_ptr<FrameAcquisition> frameAcquisition;
+            if (ACQUISITION_THREAD)
+            {
+                frameRing.reset(new FrameRing{static_cast<int>(HEIGHT), static_cast<int>(WIDTH), CV_8UC4});
+                frameAcquisition.reset(new FrameAcquisition{*sharedMemory, frameIngestor, *frameRing, lockHoldStats, VERBOSE});
+                frameAcquisition->RequestFullFrame(isDirectionFrame(1));
+                frameAcquisition->Start();
+            }
 
-                frameCount++; // Count the number of frames processed.
+            uint64_t replacedFramesSeen{0};
+            // A direction check that is due but still waits for a frame with the upper part.
+            bool directionCheckPending{false};
 
+            // Endless loop; end the program by pressing Ctrl-C.
+            while (od4.isRunning())
+            {
                 // OpenCV data structure to hold an image.
 
                 cv::Mat img;
-                cv::Mat hsvImg; // HSV Image
-                cv::Mat finalThresh;
 
-                // Wait for a notification of a new frame.
-                sharedMemory->wait();
+                bool directionFrame{false};
+                uint64_t sequence{0};
+                int64_t sampleTimePoint{0};
+                bool holdLockWhileProcessing{false};
+                std::chrono::steady_clock::time_point lockAcquired;
 
-                // Lock the shared memory.
-                sharedMemory->lock();
+                if (ACQUISITION_THREAD)
                 {
-                    // Copy the pixels from the shared memory into our own data structure.
-                    cv::Mat wrapped(HEIGHT, WIDTH, CV_8UC4, sharedMemory->data());
-                    img = wrapped.clone();
+                    // Never block on the producer: if nothing new was published, back off briefly and poll again.
+                    if (!frameRing->Acquire())
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(500));
+                        continue;
+                    }
+
+                    frameCount++; // Count the number of frames processed.
+
+                    const Frame &frame = frameRing->readSlot();
+                    frameScheduler.FramesReplaced(frameRing->dropped() - replacedFramesSeen);
+                    replacedFramesSeen = frameRing->dropped();
+                    sequence = frame.sequence;
+                    img = frame.pixels;
+                    sampleTimePoint = frame.sampleTimePoint;
+                    // The upper part is only there if the producer was asked for it before it captured this frame,
+                    // so a check that is due runs on the next frame that has it rather than being skipped.
+                    directionCheckPending = directionCheckPending || isDirectionFrame(frameCount);
+                    directionFrame = directionCheckPending && frame.fullFrame;
+                    if (directionFrame)
+                    {
+                        directionCheckPending = false;
+                    }
+                    frameAcquisition->RequestFullFrame(directionCheckPending || isDirectionFrame(frameCount + 1));
+                }
+                else
+                {
+                    frameCount++; // Count the number of frames processed.
+                    sequence = static_cast<uint64_t>(frameCount);
+                    directionFrame = isDirectionFrame(frameCount);
+
+                    // Wait for a notification of a new frame.
+                    sharedMemory->wait();
+
+                    // Lock the shared memory only for as long as it takes to snapshot the pixels and their sample time.
+                    // Zero-copy ingestion reads the shared buffer in place, so in that mode the lock is kept until
+                    // the pipeline is done with the frame.
+                    holdLockWhileProcessing = (frameIngestor.mode() == FrameIngestor::Mode::ZeroCopy);
+                    std::pair<bool, cluon::data::TimeStamp> ts;
+                    sharedMemory->lock();
+                    lockAcquired = std::chrono::steady_clock::now();
+                    {
+                        // Make the pixels from the shared memory available to the pipeline.
+                        frameIngestor.Ingest(sharedMemory->data(), directionFrame);
+                        img = frameIngestor.fullFrame();
+                        ts = sharedMemory->getTimeStamp();
+                    }
+                    if (!holdLockWhileProcessing)
+                    {
+                        sharedMemory->unlock();
+                        lockHoldStats.Add(std::chrono::steady_clock::now() - lockAcquired);
+                    }
+                    sampleTimePoint = cluon::time::toMicroseconds(ts.second);
                 }
 
-                // We start off by detecting if the track is moving in a clockwise or counter-clockwise direction.
-                if (frameCount % 15 == 0 || frameCount < 10)
+                const FrameScheduler::Decision decision = frameScheduler.Decide(sequence, sampleTimePoint, cluon::time::toMicroseconds(cluon::time::now()));
+
+                // Skipped frames keep the previous steering angle.
+                if (decision.process)
                 {
-                    direction = directionCalculator.CalculateDirection(img, direction, VERBOSE);
-                    if (direction == -1)
+                    const auto processingStart = std::chrono::steady_clock::now();
+                    // The direction check and the steering path share the thresholded masks of this frame.
+                    framePipeline.BeginFrame(img);
+
+                    // With --direction=periodic the direction is checked on the upper part of some frames up front.
+                    if (directionFrame)
+                    {
+                        direction = directionCalculator.CalculateDirection(framePipeline, img.size(), direction);
+                    }
+                    // Only the bottom 50% of the image will be used for processing and contour tracking.
+                    // When the scheduler degrades the resolution, colour separation and noise removal run on a
+                    // downscaled copy and the masks are scaled back up for the contour stage.
+                    // In streaming mode the steering path never sees a mask: the blobs come straight out of the row pipeline.
+                    // The cones are detected in both directions, as they also tell the direction.
+                    const cv::Rect &steeringRegion = frameIngestor.bottomHalfRect();
+                    const bool streamFrame = STREAMING && decision.scale == 1;
+                    if (streamFrame && TRACKING)
+                    {
+                        coneTracker.Process(framePipeline, steeringRegion, steeringRegion.height - AngleCalculator::CROP_HEIGHT);
+                    }
+                    else if (streamFrame)
                     {
-                        if (VERBOSE)
+                        framePipeline.ProcessCoarseToFine(steeringRegion, steeringRegion.height - AngleCalculator::CROP_HEIGHT, COARSE_LEVEL);
+                    }
+                    else
+                    {
+                        framePipeline.Process(steeringRegion, decision.scale);
+                        angleCalculator.ExtractBlobs(framePipeline.yellowMask(), framePipeline.blueMask());
+                        // The tracks would be stale by the next streamed frame.
+                        coneTracker.Reset();
+                    }
+                    const std::vector<Blob> &yellowBlobs = streamFrame ? framePipeline.yellowBlobs() : angleCalculator.yellowDetections();
+                    const std::vector<Blob> &blueBlobs = streamFrame ? framePipeline.blueBlobs() : angleCalculator.blueDetections();
+
+                    // We detect if the track is moving in a clockwise or counter-clockwise direction from the cones.
+                    const int previousDirection = direction;
+                    if (!PERIODIC_DIRECTION)
+                    {
+                        direction = directionEstimator.Update(yellowBlobs, blueBlobs, steeringRegion.width);
+                    }
+                    if (VERBOSE && (directionFrame || direction != previousDirection))
+                    {
+                        if (direction == -1)
                         {
                             std::cout << "Direction: Clockwise" << std::endl;
                         }
-                    }
-                    else if (direction == 1)
-                    {
-                        if (VERBOSE)
+                        else if (direction == 1)
                         {
                             std::cout << "Direction: Counter-Clockwise" << std::endl;
                         }
-                    }
-                    else
-                    {
-                        if (VERBOSE)
+                        else
                         {
                             std::cout << "Direction: No direction" << std::endl;
                         }
                     }
-                }
-                // Crop bottom half. Only bottom 50% part will be used for processing and contour tracking.
-                cv::Rect roi(0, img.rows / 2, img.cols, img.rows / 2);
-                cv::Mat croppedImg = img(roi);
 
-                // inRange filters out blue colors. Use gaussian blur to smooth out image, and morphological operations
-                // Erode makes objects smaller but fills in the holes. Dilate does the opposite, so if you combine them
-                // it will make a nice end result
-                cv::cvtColor(croppedImg, hsvImg, CV_BGR2HSV);
-
-                cv::Mat blueThreshImg = colorSeparator.detectBlueColor(hsvImg, VERBOSE);
-                cv::Mat yellowThreshImg = colorSeparator.detectYellowColor(hsvImg, VERBOSE);
-
-                yellowThreshImg = noiseRemover.RemoveNoise(yellowThreshImg);
-                blueThreshImg = noiseRemover.RemoveNoise(blueThreshImg);
-
-                // cv::Mat yellowContourOutput = contourFinder.FindContours(yellowThreshImg, img, minContourArea, maxContourArea);
-                // cv::Mat blueContourOutput = contourFinder.FindContours(blueThreshImg, img, minContourArea, maxContourArea);
-
-                // If clockwise map, blue cones on left side, yellow cones on right side.
-                // If counter-clockwise map, blue cones on right side, yellow cones on left side.
-                if (direction == 1)
-                {
-                    // use ml steering angle
-                    steeringWheelAngle = MLSteeringAngle;
-                }
-                else
+                    // If clockwise map, blue cones on left side, yellow cones on right side.
+                    // If counter-clockwise map, blue cones on right side, yellow cones on left side.
+                    double features[SteeringModel::FEATURE_COUNT];
+                    if (direction == 1 && steeringModel.loaded() && sensorState.Load(features, steeringModel.featureCount()))
+                    {
+                        // Same model as the Python service, evaluated in the frame on the latest samples.
+                        const auto inferenceStart = std::chrono::steady_clock::now();
+                        steeringWheelAngle = static_cast<float>(steeringModel.Predict(features));
+                        modelTiming.Add(std::chrono::steady_clock::now() - inferenceStart);
+                    }
+                    else if (direction == 1)
+                    {
+                        // use ml steering angle, also while the model waits for the first sample of every sensor it uses
+                        steeringWheelAngle = MLSteeringAngle;
+                    }
+                    else
+                    {
+                        bool isClockwise = (direction == -1);
+                        steeringWheelAngle = angleCalculator.CalculateSteeringAngle(yellowBlobs, blueBlobs, steeringRegion.size(), steeringWheelAngle, isClockwise, maxSteering, minSteering, VERBOSE);
+                    }
 
-                {
-                    bool isClockwise = (direction == -1);
-                    steeringWheelAngle = angleCalculator.CalculateSteeringAngle(yellowThreshImg, blueThreshImg, steeringWheelAngle, isClockwise, maxSteering, minSteering, VERBOSE);
+                    frameScheduler.FrameProcessed(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - processingStart).count());
                 }
 
                 // cv::bitwise_or(blueContourOutput, yellowContourOutput, finalThresh);
@@ -220,14 +507,11 @@ int32_t main(int32_t argc, char **argv)
                 // cv::Mat finalOutput;
                 // cv::addWeighted(img, 1.0, finalThresh, 1.0, 0.0, finalOutput);
 
-                // TODO: Here, you can add some code to check the sampleTimePoint when the current frame was captured.
-
-                std::pair<bool, cluon::data::TimeStamp> ts = sharedMemory->getTimeStamp();
-
-                int64_t sampleTimePoint = cluon::time::toMicroseconds(ts.second);
-                std::string ts_string = std::to_string(sampleTimePoint);
-
-                sharedMemory->unlock();
+                if (holdLockWhileProcessing)
+                {
+                    sharedMemory->unlock();
+                    lockHoldStats.Add(std::chrono::steady_clock::now() - lockAcquired);
+                }
 
                 // If you want to access the latest received ground steering, don't forget to lock the mutex:
                 {
@@ -239,7 +523,7 @@ int32_t main(int32_t argc, char **argv)
                     float upperBound = std::max(actualSteering * 0.75f, actualSteering * 1.25f);
 
                     bool isWithinRange = (steeringWheelAngle >= lowerBound) && (steeringWheelAngle <= upperBound);
-                    std::cout << "group_16;" << ts_string << ";" << steeringWheelAngle << std::endl;
+                    std::cout << "group_16;" << sampleTimePoint << ";" << steeringWheelAngle << std::endl;
                     if (actualSteering != 0.0)
                     {
 
@@ -256,26 +540,74 @@ int32_t main(int32_t argc, char **argv)
                     }
 
                     // write to file
-                    outputFile << ts_string << "," << steeringWheelAngle << "," << gsr.groundSteering() << "\n";
+                    outputFile << sampleTimePoint << "," << steeringWheelAngle << "," << gsr.groundSteering() << "\n";
 
                     // check if the steering angle is within +-25% of the actual steering
                 }
 
-                // Display image on your screen.
-                if (VERBOSE)
+                if (VERBOSE && frameCount % 100 == 0)
                 {
-                    // cv::imshow(sharedMemory->name().c_str(), img);
-                    // cv::imshow("ResultImg", img);
-                    // cv::imshow("Blue", blueContourOutput);
-                    // cv::imshow("Yellow", yellowContourOutput);
-                    // cv::imshow("Combined Color tracking", finalOutput);
-
-                    cv::waitKey(1);
+                    if (!ACQUISITION_THREAD)
+                    {
+                        lockHoldStats.Print(std::clog);
+                    }
+                    frameScheduler.Print(std::clog);
+                    contourFinder.probe().Print(std::clog);
+                    if (TRACKING)
+                    {
+                        coneTracker.Print(std::clog);
+                    }
+                    if (!PERIODIC_DIRECTION)
+                    {
+                        directionEstimator.Print(std::clog);
+                    }
                 }
+
+                // Display image on your screen: done by the DebugUi thread.
+                // cv::imshow(sharedMemory->name().c_str(), img);
+                // cv::imshow("ResultImg", img);
+                // cv::imshow("Blue", blueContourOutput);
+                // cv::imshow("Yellow", yellowContourOutput);
+                // cv::imshow("Combined Color tracking", finalOutput);
+            }
+
+            std::cout << "Pipeline frames: " << framePipeline.framesProcessed() << ", frames with buffer reallocations at steady state: " << framePipeline.reallocations() << std::endl;
+            framePipeline.PrintTimings(std::cout);
+            contourFinder.probe().Print(std::cout);
+            if (TRACKING)
+            {
+                coneTracker.Print(std::cout);
+            }
+            if (!PERIODIC_DIRECTION)
+            {
+                directionEstimator.Print(std::cout);
+            }
+            if (modelTiming.count() > 0)
+            {
+                modelTiming.Print(std::cout);
+            }
+            if (VERBOSE)
+            {
+                debugUi.Stop();
+                visualizationSink.Stop();
+                visualizationSink.Print(std::cout);
+            }
+            if (VERIFY)
+            {
+                std::cout << "Verification: " << framePipeline.mismatchedPixels() << " mismatching pixels, " << framePipeline.mismatchedDenoisedPixels() << " after noise removal" << std::endl;
+            }
+
+            if (frameAcquisition)
+            {
+                frameAcquisition->Stop();
+                std::cout << "Frames captured: " << frameRing->published() << ", processed: " << frameCount << ", dropped: " << frameRing->dropped() << std::endl;
             }
         }
         retCode = 0;
 
+        std::cout << "Ingest mode: " << FrameIngestor::modeName(frameIngestor.mode()) << ", bytes saved per frame: " << frameIngestor.averageBytesSaved() << " (last: " << frameIngestor.lastBytesSaved() << ")" << std::endl;
+        lockHoldStats.Print(std::cout);
+        frameScheduler.Print(std::cout);
         std::cout << "Total entries: " << totalEntries << std::endl;
         std::cout << "Total within range: " << totalWithinRange << std::endl;
         // print percentage of frames within range
@@ -0,0 +1,173 @@
+// Replays a sequence of synthetic frames through the default steering path (FramePipeline::Process
+// with the fused colour separation and the filter noise removal, then the blob extraction and the
+// steering decision of AngleCalculator) and fails if anything is allocated once the sequence has
+// been seen once. The denoised masks are also compared with the OpenCV reference of the noise
+// removal, outside of the counted part.
+//
+// Allocations are counted by interposing the glibc allocation functions; operator new and
+// OpenCV's fastMalloc end up in them.
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <malloc.h>
+#include "AngleCalculator.hpp"
+#include "CommonDefs.hpp"
+#include "FramePipeline.hpp"
+#include "SegmentationKernels.hpp"
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+extern "C" void *__libc_memalign(size_t alignment, size_t size);
+
+namespace
+{
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocations{0};
+
+void countAllocation()
+{
+    if (counting.load(std::memory_order_relaxed))
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+constexpr int WIDTH = 640;
+constexpr int HEIGHT = 480;
+constexpr int FRAMES = 30;
+// The first pass warms the buffers up; the following ones must not allocate.
+constexpr int PASSES = 3;
+
+// BGRA frames (as in the shared memory) with noise, cones that move towards the car from frame
+// to frame, and speckles for the noise removal.
+std::vector<cv::Mat> replayFrames()
+{
+    const HsvThresholds thresholds = colorSeparator.thresholds();
+    cv::Mat hsv(1, 2, CV_8UC3);
+    hsv.at<cv::Vec3b>(0, 0) = cv::Vec3b(static_cast<uchar>((thresholds.blue.lowH + thresholds.blue.highH) / 2),
+                                        static_cast<uchar>((thresholds.blue.lowS + thresholds.blue.highS) / 2),
+                                        static_cast<uchar>((thresholds.blue.lowV + thresholds.blue.highV) / 2));
+    hsv.at<cv::Vec3b>(0, 1) = cv::Vec3b(static_cast<uchar>((thresholds.yellow.lowH + thresholds.yellow.highH) / 2),
+                                        static_cast<uchar>((thresholds.yellow.lowS + thresholds.yellow.highS) / 2),
+                                        static_cast<uchar>((thresholds.yellow.lowV + thresholds.yellow.highV) / 2));
+    cv::Mat bgr;
+    cv::cvtColor(hsv, bgr, cv::COLOR_HSV2BGR);
+    const cv::Scalar blue(bgr.at<cv::Vec3b>(0, 0)[0], bgr.at<cv::Vec3b>(0, 0)[1], bgr.at<cv::Vec3b>(0, 0)[2], 255);
+    const cv::Scalar yellow(bgr.at<cv::Vec3b>(0, 1)[0], bgr.at<cv::Vec3b>(0, 1)[1], bgr.at<cv::Vec3b>(0, 1)[2], 255);
+
+    std::vector<cv::Mat> frames;
+    cv::RNG rng(FRAMES);
+    for (int i = 0; i < FRAMES; i++)
+    {
+        cv::Mat frame(HEIGHT, WIDTH, CV_8UC4);
+        rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar(40, 40, 40, 255), cv::Scalar(140, 140, 140, 256));
+        for (int cone = 0; cone < 4; cone++)
+        {
+            const int y = HEIGHT / 2 + 20 + cone * 40 + (i * 3) % 40;
+            const int size = 14 + cone * 4;
+            cv::rectangle(frame, cv::Rect(120 - cone * 30 - i, y, size, size + 6), blue, cv::FILLED);
+            cv::rectangle(frame, cv::Rect(500 + cone * 30 + i, y, size, size + 6), yellow, cv::FILLED);
+        }
+        for (int speckle = 0; speckle < 300; speckle++)
+        {
+            const cv::Scalar &color = (speckle % 2 == 0) ? blue : yellow;
+            frame.at<cv::Vec4b>(rng.uniform(0, HEIGHT), rng.uniform(0, WIDTH)) =
+                cv::Vec4b(static_cast<uchar>(color[0]), static_cast<uchar>(color[1]), static_cast<uchar>(color[2]), 255);
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+} // namespace
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **pointer, size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    *pointer = __libc_memalign(alignment, size);
+    return (*pointer != nullptr) ? 0 : ENOMEM;
+}
+
+int main()
+{
+    const std::vector<cv::Mat> frames = replayFrames();
+    const cv::Rect steeringRegion(0, HEIGHT / 2, WIDTH, HEIGHT / 2);
+
+    SegmentationKernels::Select();
+    FramePipeline framePipeline;
+    AngleCalculator angleCalculator;
+    float steeringWheelAngle = 0.0f;
+
+    cv::Mat referenceDenoised;
+    cv::Mat referenceBlurred;
+    cv::Mat referenceEroded;
+    uint64_t mismatchedPixels = 0;
+    uint64_t steadyAllocations = 0;
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        for (int i = 0; i < FRAMES; i++)
+        {
+            allocations.store(0);
+            counting.store(true);
+            framePipeline.BeginFrame(frames[static_cast<size_t>(i)]);
+            framePipeline.Process(steeringRegion, 1);
+            angleCalculator.ExtractBlobs(framePipeline.yellowMask(), framePipeline.blueMask());
+            steeringWheelAngle = angleCalculator.CalculateSteeringAngle(angleCalculator.yellowDetections(), angleCalculator.blueDetections(),
+                                                                        steeringRegion.size(), steeringWheelAngle, true, 0.3f, -0.3f, false);
+            counting.store(false);
+            if (pass > 0 && allocations.load() > 0)
+            {
+                std::cerr << "FramePipeline allocation test: pass " << pass << ", frame " << i << ": " << allocations.load() << " allocations." << std::endl;
+                steadyAllocations += allocations.load();
+            }
+
+            if (pass == 0)
+            {
+                noiseRemover.RemoveNoiseReference(framePipeline.segmentedYellow(steeringRegion), referenceDenoised, referenceBlurred, referenceEroded);
+                mismatchedPixels += static_cast<uint64_t>(cv::countNonZero(referenceDenoised != framePipeline.yellowMask()));
+                noiseRemover.RemoveNoiseReference(framePipeline.segmentedBlue(steeringRegion), referenceDenoised, referenceBlurred, referenceEroded);
+                mismatchedPixels += static_cast<uint64_t>(cv::countNonZero(referenceDenoised != framePipeline.blueMask()));
+            }
+        }
+    }
+
+    std::cout << "FramePipeline allocation test: " << FRAMES << " frames, " << PASSES - 1 << " passes after warm-up: " << steadyAllocations
+              << " allocations, " << framePipeline.reallocations() << " buffer reallocations, " << mismatchedPixels
+              << " denoised pixels differing from the OpenCV reference." << std::endl;
+    return (steadyAllocations == 0 && framePipeline.reallocations() == 0 && mismatchedPixels == 0) ? 0 : 1;
+}
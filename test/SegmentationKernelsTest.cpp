@@ -0,0 +1,174 @@
+// Runs every vector variant of the segmentation kernels compiled into this binary against the
+// scalar reference: the threshold over every width up to a few vector lengths and some frame
+// widths, at unaligned addresses, with bounds at and around the pixel values; the erode and dilate
+// over grey and sparse binary rows, including the first and last rows (above or below == row).
+// Prints the first differing pixel of each kernel and fails on any difference. Variants the CPU
+// cannot run are reported as skipped.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "SegmentationKernelVariants.hpp"
+
+namespace
+{
+constexpr int ROUNDS = 16;
+constexpr int ALIGNMENTS = 4;
+
+uint32_t nextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+std::vector<int> testedWidths()
+{
+    std::vector<int> widths;
+    for (int width = 1; width <= 130; width++)
+    {
+        widths.push_back(width);
+    }
+    for (int width : {255, 256, 257, 639, 640, 641, 1023})
+    {
+        widths.push_back(width);
+    }
+    return widths;
+}
+
+// Prints the first difference; returns whether the rows are equal.
+bool compareRows(const SegmentationKernelVariant &variant, const char *kernel, int width, int offset, int round,
+                 const uint8_t *expected, const uint8_t *actual)
+{
+    for (int x = 0; x < width; x++)
+    {
+        if (expected[x] != actual[x])
+        {
+            std::cerr << "Segmentation kernels test: '" << variant.name << "' " << kernel << ", width " << width << ", offset "
+                      << offset << ", round " << round << ": x " << x << " is " << static_cast<int>(actual[x]) << ", expected "
+                      << static_cast<int>(expected[x]) << "." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Bounds from the pixels themselves, so that values equal to and one off the bounds occur; every
+// fourth round uses random (also inverted) bounds.
+void pickBounds(const uint8_t *hsv, int width, int round, uint32_t &state, uint8_t *bounds)
+{
+    for (int i = 0; i < 12; i++)
+    {
+        const int channel = i % 3;
+        const uint8_t pixel = hsv[3 * static_cast<int>(nextRandom(state) % static_cast<uint32_t>(width)) + channel];
+        const int offset = static_cast<int>(nextRandom(state) % 3) - 1;
+        const int edge = ((i % 6) < 3) ? pixel + offset : pixel - offset;
+        bounds[i] = (round % 4 == 3) ? static_cast<uint8_t>(nextRandom(state)) : static_cast<uint8_t>(std::min(255, std::max(0, edge)));
+    }
+    if (round % 8 == 1)
+    {
+        // Full range for blue, empty for yellow.
+        for (int i = 0; i < 3; i++)
+        {
+            bounds[i] = 0;
+            bounds[i + 3] = 255;
+            bounds[i + 6] = 255;
+            bounds[i + 9] = 0;
+        }
+    }
+}
+
+bool testVariant(const SegmentationKernelVariant &variant)
+{
+    const SegmentationKernelVariant &reference = scalarKernels();
+    uint32_t state = 0x2545f491u;
+    bool passed = true;
+
+    for (int width : testedWidths())
+    {
+        const size_t size = static_cast<size_t>(width);
+        // Allocated with room for the offsets, so a vector load past the end of the row shows up
+        // in tools like ASan instead of reading a neighbouring row.
+        std::vector<uint8_t> hsvBuffer(3 * size + ALIGNMENTS);
+        std::vector<uint8_t> rowBuffer(3 * size + ALIGNMENTS);
+        std::vector<uint8_t> expectedBlue(size), expectedYellow(size);
+        std::vector<uint8_t> actualBuffer(2 * (size + ALIGNMENTS));
+
+        for (int offset = 0; offset < ALIGNMENTS; offset++)
+        {
+            uint8_t *hsv = hsvBuffer.data() + offset;
+            uint8_t *rows = rowBuffer.data() + offset;
+            uint8_t *actualBlue = actualBuffer.data() + offset;
+            uint8_t *actualYellow = actualBlue + size + ALIGNMENTS;
+
+            for (int round = 0; round < ROUNDS; round++)
+            {
+                for (size_t i = 0; i < 3 * size; i++)
+                {
+                    hsv[i] = static_cast<uint8_t>(nextRandom(state));
+                }
+                uint8_t bounds[12];
+                pickBounds(hsv, width, round, state, bounds);
+                reference.thresholdRow(hsv, width, bounds, expectedBlue.data(), expectedYellow.data());
+                variant.thresholdRow(hsv, width, bounds, actualBlue, actualYellow);
+                passed = compareRows(variant, "threshold (blue)", width, offset, round, expectedBlue.data(), actualBlue) && passed;
+                passed = compareRows(variant, "threshold (yellow)", width, offset, round, expectedYellow.data(), actualYellow) && passed;
+
+                // Grey rows on even rounds, sparse binary masks (as after the threshold) on odd ones.
+                for (size_t i = 0; i < 3 * size; i++)
+                {
+                    const uint32_t r = nextRandom(state);
+                    rows[i] = (round % 2 == 0) ? static_cast<uint8_t>(r) : ((r & 7) == 0 ? 0 : 255);
+                }
+                const uint8_t *above = rows;
+                const uint8_t *row = above + width;
+                const uint8_t *below = row + width;
+                // The first row of an image passes itself as the row above, the last one as the row below.
+                if (round % 4 == 2)
+                {
+                    above = row;
+                }
+                else if (round % 4 == 3)
+                {
+                    below = row;
+                }
+                reference.erodeRow(above, row, below, expectedBlue.data(), width);
+                variant.erodeRow(above, row, below, actualBlue, width);
+                passed = compareRows(variant, "erode", width, offset, round, expectedBlue.data(), actualBlue) && passed;
+                reference.dilateRow(above, row, below, expectedYellow.data(), width);
+                variant.dilateRow(above, row, below, actualYellow, width);
+                passed = compareRows(variant, "dilate", width, offset, round, expectedYellow.data(), actualYellow) && passed;
+            }
+        }
+    }
+    return passed;
+}
+} // namespace
+
+int main()
+{
+    CompiledKernelVariant compiled[MAX_VECTOR_KERNELS];
+    const int count = compiledVectorKernels(compiled);
+    if (count == 0)
+    {
+        std::cout << "Segmentation kernels test: no vector variants compiled for this architecture." << std::endl;
+    }
+
+    int failed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const SegmentationKernelVariant &variant = *compiled[i].variant;
+        if (!compiled[i].supported)
+        {
+            std::cout << "Segmentation kernels test: '" << variant.name << "' skipped, not supported by this CPU." << std::endl;
+            continue;
+        }
+        const bool passed = testVariant(variant);
+        std::cout << "Segmentation kernels test: '" << variant.name << "' " << (passed ? "matches" : "DOES NOT MATCH")
+                  << " the scalar reference." << std::endl;
+        failed += passed ? 0 : 1;
+    }
+    return (failed == 0) ? 0 : 1;
+}